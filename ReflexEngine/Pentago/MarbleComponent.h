@@ -1,10 +1,13 @@
 #pragma once
 
 #include "..\ReflexEngine\Component.h"
+#include "..\ReflexEngine\ComponentPool.h"
 
 // Class definition
 struct Marble : public Reflex::Components::Component
 {
 	explicit Marble( bool isPlayer ) : isPlayer( isPlayer ) { }
 	bool isPlayer = true;
-};
\ No newline at end of file
+};
+
+REFLEX_TRIVIALLY_RELOCATABLE( Marble )
\ No newline at end of file
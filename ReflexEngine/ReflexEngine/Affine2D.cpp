@@ -0,0 +1,141 @@
+#include "Affine2D.h"
+
+namespace Reflex
+{
+	Affine2D Affine2D::FromTransform( const sf::Transform& transform )
+	{
+		const auto* matrix = transform.getMatrix();
+		return Affine2D( matrix[0], matrix[4], matrix[12], matrix[1], matrix[5], matrix[13] );
+	}
+
+	Affine2D Affine2D::FromComponents( const sf::Vector2f& position, const float rotation, const sf::Vector2f& scale, const sf::Vector2f& origin )
+	{
+		const auto angleRadians = TORADIANS( rotation );
+		const float cosR = cos( angleRadians );
+		const float sinR = sin( angleRadians );
+		const float a = scale.x * cosR, b = -scale.y * sinR;
+		const float c = scale.x * sinR, d = scale.y * cosR;
+		return Affine2D( a, b, position.x - origin.x * a - origin.y * b, c, d, position.y - origin.x * c - origin.y * d );
+	}
+
+	Affine2D Affine2D::Rotation( const float angleDegrees, const sf::Vector2f& centre )
+	{
+		return FromComponents( centre, angleDegrees, sf::Vector2f( 1.0f, 1.0f ), centre );
+	}
+
+	sf::Transform Affine2D::ToTransform() const
+	{
+		return sf::Transform( a, b, x, c, d, y, 0.0f, 0.0f, 1.0f );
+	}
+
+	Affine2D Affine2D::operator*( const Affine2D& other ) const
+	{
+		return Affine2D(
+			a * other.a + b * other.c, a * other.b + b * other.d, a * other.x + b * other.y + x,
+			c * other.a + d * other.c, c * other.b + d * other.d, c * other.x + d * other.y + y );
+	}
+
+	Affine2D Affine2D::GetInverse() const
+	{
+		const float determinant = GetDeterminant();
+
+		if( determinant == 0.0f )
+			return Affine2D();
+
+		const float inv = 1.0f / determinant;
+		return Affine2D(
+			d * inv, -b * inv, ( b * y - d * x ) * inv,
+			-c * inv, a * inv, ( c * x - a * y ) * inv );
+	}
+
+	float Affine2D::GetRotation() const
+	{
+		return TODEGREES( atan2( c, a ) );
+	}
+
+	sf::Vector2f Affine2D::GetScale() const
+	{
+		const float scaleX = sqrt( a * a + c * c );
+		return sf::Vector2f( scaleX, scaleX == 0.0f ? 0.0f : GetDeterminant() / scaleX );
+	}
+
+	void Affine2DArray::resize( const unsigned size )
+	{
+		m_a.resize( size ); m_b.resize( size ); m_x.resize( size );
+		m_c.resize( size ); m_d.resize( size ); m_y.resize( size );
+	}
+
+	void Affine2DArray::push_back( const Affine2D& affine )
+	{
+		m_a.push_back( affine.a ); m_b.push_back( affine.b ); m_x.push_back( affine.x );
+		m_c.push_back( affine.c ); m_d.push_back( affine.d ); m_y.push_back( affine.y );
+	}
+
+	void Affine2DArray::Set( const unsigned index, const Affine2D& affine )
+	{
+		m_a[index] = affine.a; m_b[index] = affine.b; m_x[index] = affine.x;
+		m_c[index] = affine.c; m_d[index] = affine.d; m_y[index] = affine.y;
+	}
+
+	Affine2DView Affine2DArray::GetView( const unsigned offset )
+	{
+		return Affine2DView{ m_a.data() + offset, m_b.data() + offset, m_x.data() + offset, m_c.data() + offset, m_d.data() + offset, m_y.data() + offset };
+	}
+
+	void TransformPoints( const Affine2D& affine, const sf::Vector2f* points, sf::Vector2f* out, const unsigned count )
+	{
+		unsigned i = 0U;
+
+#ifdef REFLEX_SSE
+		// Two interleaved points per register: ( x0 y0 x1 y1 ) -> ( a c a c ) * ( x0 x0 x1 x1 ) + ( b d b d ) * ( y0 y0 y1 y1 ) + ( x y x y )
+		const __m128 ac = _mm_setr_ps( affine.a, affine.c, affine.a, affine.c );
+		const __m128 bd = _mm_setr_ps( affine.b, affine.d, affine.b, affine.d );
+		const __m128 xy = _mm_setr_ps( affine.x, affine.y, affine.x, affine.y );
+
+		const auto* in = reinterpret_cast< const float* >( points );
+		auto* result = reinterpret_cast< float* >( out );
+
+		for( ; i + 2U <= count; i += 2U )
+		{
+			const __m128 p = _mm_loadu_ps( in + i * 2U );
+			const __m128 xs = _mm_shuffle_ps( p, p, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+			const __m128 ys = _mm_shuffle_ps( p, p, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+			_mm_storeu_ps( result + i * 2U, _mm_add_ps( _mm_add_ps( _mm_mul_ps( ac, xs ), _mm_mul_ps( bd, ys ) ), xy ) );
+		}
+#endif
+
+		for( ; i < count; ++i )
+			out[i] = affine.TransformPoint( points[i] );
+	}
+
+	void ComposeAffines( const Affine2DView& parents, const Affine2DView& locals, const Affine2DView& out, const unsigned count )
+	{
+		unsigned i = 0U;
+
+#ifdef REFLEX_SSE
+		for( ; i + 4U <= count; i += 4U )
+		{
+			const __m128 pa = _mm_loadu_ps( parents.a + i ), pb = _mm_loadu_ps( parents.b + i ), px = _mm_loadu_ps( parents.x + i );
+			const __m128 pc = _mm_loadu_ps( parents.c + i ), pd = _mm_loadu_ps( parents.d + i ), py = _mm_loadu_ps( parents.y + i );
+			const __m128 la = _mm_loadu_ps( locals.a + i ), lb = _mm_loadu_ps( locals.b + i ), lx = _mm_loadu_ps( locals.x + i );
+			const __m128 lc = _mm_loadu_ps( locals.c + i ), ld = _mm_loadu_ps( locals.d + i ), ly = _mm_loadu_ps( locals.y + i );
+
+			_mm_storeu_ps( out.a + i, _mm_add_ps( _mm_mul_ps( pa, la ), _mm_mul_ps( pb, lc ) ) );
+			_mm_storeu_ps( out.b + i, _mm_add_ps( _mm_mul_ps( pa, lb ), _mm_mul_ps( pb, ld ) ) );
+			_mm_storeu_ps( out.x + i, _mm_add_ps( _mm_add_ps( _mm_mul_ps( pa, lx ), _mm_mul_ps( pb, ly ) ), px ) );
+			_mm_storeu_ps( out.c + i, _mm_add_ps( _mm_mul_ps( pc, la ), _mm_mul_ps( pd, lc ) ) );
+			_mm_storeu_ps( out.d + i, _mm_add_ps( _mm_mul_ps( pc, lb ), _mm_mul_ps( pd, ld ) ) );
+			_mm_storeu_ps( out.y + i, _mm_add_ps( _mm_add_ps( _mm_mul_ps( pc, lx ), _mm_mul_ps( pd, ly ) ), py ) );
+		}
+#endif
+
+		for( ; i < count; ++i )
+		{
+			const Affine2D parent( parents.a[i], parents.b[i], parents.x[i], parents.c[i], parents.d[i], parents.y[i] );
+			const Affine2D local( locals.a[i], locals.b[i], locals.x[i], locals.c[i], locals.d[i], locals.y[i] );
+			const auto result = parent * local;
+			out.a[i] = result.a; out.b[i] = result.b; out.x[i] = result.x;
+			out.c[i] = result.c; out.d[i] = result.d; out.y[i] = result.y;
+		}
+	}
+}
\ No newline at end of file
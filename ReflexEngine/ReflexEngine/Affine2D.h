@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Precompiled.h"
+
+namespace Reflex
+{
+	// 2D affine transform, the top two rows of a 3x3 matrix ( a b x / c d y / 0 0 1 )
+	// 24 bytes compared to the 64 of an sf::Transform, which stores a full 4x4 matrix
+	struct Affine2D
+	{
+		Affine2D() { }
+		Affine2D( const float a, const float b, const float x, const float c, const float d, const float y ) : a( a ), b( b ), x( x ), c( c ), d( d ), y( y ) { }
+
+		static Affine2D FromTransform( const sf::Transform& transform );
+		// Same convention as sf::Transformable (scale, then rotate clockwise in degrees, then translate, all about origin)
+		static Affine2D FromComponents( const sf::Vector2f& position, const float rotation, const sf::Vector2f& scale, const sf::Vector2f& origin = sf::Vector2f() );
+		// Same direction as RotateAroundPoint, computing the sine and cosine once for any number of points
+		static Affine2D Rotation( const float angleDegrees, const sf::Vector2f& centre = sf::Vector2f() );
+
+		sf::Transform ToTransform() const;
+
+		// ( *this * other ) applies other first
+		Affine2D operator*( const Affine2D& other ) const;
+		Affine2D& operator*=( const Affine2D& other ) { return *this = *this * other; }
+
+		// Singular transforms return the identity
+		Affine2D GetInverse() const;
+		float GetDeterminant() const { return a * d - b * c; }
+
+		sf::Vector2f TransformPoint( const sf::Vector2f& point ) const { return sf::Vector2f( a * point.x + b * point.y + x, c * point.x + d * point.y + y ); }
+		sf::Vector2f TransformVector( const sf::Vector2f& vector ) const { return sf::Vector2f( a * vector.x + b * vector.y, c * vector.x + d * vector.y ); }
+
+		// Decomposition assumes no shear, which holds for a single transformable but not always for a chain of non uniformly scaled ones
+		sf::Vector2f GetTranslation() const { return sf::Vector2f( x, y ); }
+		float GetRotation() const;
+		sf::Vector2f GetScale() const;
+
+		float a = 1.0f, b = 0.0f, x = 0.0f;
+		float c = 0.0f, d = 1.0f, y = 0.0f;
+	};
+
+	static_assert( sizeof( Affine2D ) == 24, "Affine2D should stay tightly packed" );
+
+	// Pointers to the six elements of a run of affines stored one array per element (see Affine2DArray)
+	struct Affine2DView
+	{
+		float* a;
+		float* b;
+		float* x;
+		float* c;
+		float* d;
+		float* y;
+	};
+
+	// Affines stored one array per element, the layout the batch kernels below work on
+	class Affine2DArray
+	{
+	public:
+		unsigned size() const { return ( unsigned )m_a.size(); }
+		bool empty() const { return m_a.empty(); }
+		void resize( const unsigned size );
+		void clear() { resize( 0U ); }
+		void push_back( const Affine2D& affine );
+
+		Affine2D Get( const unsigned index ) const { return Affine2D( m_a[index], m_b[index], m_x[index], m_c[index], m_d[index], m_y[index] ); }
+		void Set( const unsigned index, const Affine2D& affine );
+
+		Affine2DView GetView( const unsigned offset = 0U );
+
+	private:
+		std::vector< float > m_a, m_b, m_x, m_c, m_d, m_y;
+	};
+
+	// Batch kernels, SSE where the target supports it with a scalar fallback (and for any remainder)
+	// Outputs may alias inputs
+
+	// out[i] = affine * points[i]
+	void TransformPoints( const Affine2D& affine, const sf::Vector2f* points, sf::Vector2f* out, const unsigned count );
+
+	// out[i] = parents[i] * locals[i]
+	void ComposeAffines( const Affine2DView& parents, const Affine2DView& locals, const Affine2DView& out, const unsigned count );
+}
\ No newline at end of file
@@ -0,0 +1,386 @@
+#include "ArchetypeStorage.h"
+#include "Object.h"
+
+namespace Reflex
+{
+	namespace Core
+	{
+		Archetype::Archetype( const std::vector< const ComponentTypeInfo* >& columns )
+			: m_columns( columns )
+		{
+			unsigned rowBytes = 0U;
+
+			for( auto* column : m_columns )
+			{
+				m_signature.push_back( column->type );
+				rowBytes += column->size;
+			}
+
+			m_rowsPerChunk = std::max( 1U, ( unsigned )ChunkSizeBytes / std::max( 1U, rowBytes ) );
+
+			// Lay the columns out one after another, each starting on an aligned boundary
+			for( auto* column : m_columns )
+			{
+				m_columnOffsets.push_back( m_chunkBytes );
+				m_chunkBytes += ( column->size * m_rowsPerChunk + ColumnAlignment - 1U ) & ~( ( unsigned )ColumnAlignment - 1U );
+			}
+		}
+
+		Archetype::~Archetype()
+		{
+			// Components must be destroyed by the storage before the archetype goes away
+			assert( m_owners.empty() );
+		}
+
+		const std::vector< TypeId >& Archetype::GetSignature() const
+		{
+			return m_signature;
+		}
+
+		unsigned Archetype::Size() const
+		{
+			return ( unsigned )m_owners.size();
+		}
+
+		unsigned Archetype::GetChunkCount() const
+		{
+			return ( Size() + m_rowsPerChunk - 1U ) / m_rowsPerChunk;
+		}
+
+		unsigned Archetype::GetChunkSize( const unsigned chunk ) const
+		{
+			return std::min( m_rowsPerChunk, Size() - chunk * m_rowsPerChunk );
+		}
+
+		int Archetype::FindColumn( const TypeId type ) const
+		{
+			const auto found = std::lower_bound( m_signature.begin(), m_signature.end(), type );
+
+			if( found == m_signature.end() || *found != type )
+				return -1;
+
+			return ( int )( found - m_signature.begin() );
+		}
+
+		void* Archetype::GetColumn( const unsigned chunk, const unsigned column ) const
+		{
+			return m_chunks[chunk].get() + m_columnOffsets[column];
+		}
+
+		void* Archetype::GetElement( const unsigned row, const unsigned column ) const
+		{
+			return m_chunks[row / m_rowsPerChunk].get() + m_columnOffsets[column] + ( row % m_rowsPerChunk ) * m_columns[column]->size;
+		}
+
+		Object* Archetype::GetOwner( const unsigned row ) const
+		{
+			return m_owners[row];
+		}
+
+		unsigned Archetype::AddRow( Object* owner )
+		{
+			const unsigned row = Size();
+
+			// Chunks are never reallocated, growing just adds another one
+			if( row == m_chunks.size() * m_rowsPerChunk )
+				m_chunks.emplace_back( new char[m_chunkBytes] );
+
+			m_owners.push_back( owner );
+			return row;
+		}
+
+		Object* Archetype::RemoveRow( const unsigned row, HandleManager& handleManager )
+		{
+			const unsigned last = Size() - 1U;
+			Object* moved = nullptr;
+
+			if( row != last )
+			{
+				for( unsigned column = 0U; column < m_columns.size(); ++column )
+				{
+					void* dest = GetElement( row, column );
+					m_columns[column]->relocate( dest, GetElement( last, column ) );
+					handleManager.Update( dest, m_columns[column]->toEntity( dest )->m_self );
+				}
+
+				moved = m_owners[last];
+				m_owners[row] = moved;
+			}
+
+			m_owners.pop_back();
+
+			// Release chunks only once more than the spares are empty
+			while( m_chunks.size() > SpareChunks && m_owners.size() <= ( m_chunks.size() - 1U - SpareChunks ) * m_rowsPerChunk )
+				m_chunks.pop_back();
+
+			return moved;
+		}
+
+		ArchetypeStorage::ArchetypeStorage( HandleManager& handleManager )
+			: m_handleManager( handleManager )
+		{
+
+		}
+
+		ArchetypeStorage::~ArchetypeStorage()
+		{
+			Clear();
+		}
+
+		Archetype& ArchetypeStorage::GetArchetype( const std::vector< TypeId >& signature )
+		{
+			auto found = m_archetypes.find( signature );
+
+			if( found == m_archetypes.end() )
+			{
+				std::vector< const ComponentTypeInfo* > columns;
+
+				for( auto type : signature )
+				{
+					assert( type < m_types.size() && m_types[type] );
+					columns.push_back( m_types[type].get() );
+				}
+
+				found = m_archetypes.insert( std::make_pair( signature, std::make_unique< Archetype >( columns ) ) ).first;
+			}
+
+			return *found->second;
+		}
+
+		void ArchetypeStorage::MoveRow( Archetype& source, const unsigned sourceRow, Archetype& dest, const unsigned destRow, const int skipSource, const int skipDest )
+		{
+			unsigned destColumn = 0U;
+
+			for( unsigned column = 0U; column < source.m_columns.size(); ++column )
+			{
+				if( ( int )column == skipSource )
+					continue;
+
+				if( ( int )destColumn == skipDest )
+					++destColumn;
+
+				void* destData = dest.GetElement( destRow, destColumn );
+				source.m_columns[column]->relocate( destData, source.GetElement( sourceRow, column ) );
+				m_handleManager.Update( destData, source.m_columns[column]->toEntity( destData )->m_self );
+				++destColumn;
+			}
+		}
+
+		void* ArchetypeStorage::BeginAddComponent( Object& object, const TypeId type )
+		{
+			// Builds on any add to this object still in progress
+			const PendingAdd* previous = nullptr;
+			for( auto& pending : m_pending )
+				if( pending.object == &object )
+					previous = &pending;
+
+			auto* current = previous ? previous->location.archetype : object.m_archetypeLocation.archetype;
+			auto signature = current ? current->GetSignature() : std::vector< TypeId >();
+
+			// New component goes after any existing components of the same type
+			const auto insertAt = std::upper_bound( signature.begin(), signature.end(), type );
+			const auto column = ( int )( insertAt - signature.begin() );
+			signature.insert( insertAt, type );
+
+			auto& dest = GetArchetype( signature );
+			const auto row = dest.AddRow( &object );
+			m_pending.push_back( PendingAdd{ &object, ArchetypeLocation{ &dest, row }, column } );
+
+			return dest.GetElement( row, column );
+		}
+
+		void ArchetypeStorage::EndAddComponent( Object& object )
+		{
+			assert( m_pendingEnded < m_pending.size() );
+
+			// Still inside an outer add's constructor
+			if( ++m_pendingEnded < m_pending.size() )
+				return;
+
+			FinishPendingAdds();
+		}
+
+		void ArchetypeStorage::FinishPendingAdds()
+		{
+			m_releasedRows.clear();
+
+			for( unsigned i = 0U; i < m_pending.size(); ++i )
+			{
+				auto* object = m_pending[i].object;
+
+				// Each object is finished from its first entry, its last entry is where it ends up
+				bool first = true;
+				unsigned last = i;
+				for( unsigned j = 0U; j < m_pending.size(); ++j )
+				{
+					if( m_pending[j].object != object )
+						continue;
+
+					first = first && j >= i;
+					last = j;
+				}
+
+				if( !first )
+					continue;
+
+				auto& location = object->m_archetypeLocation;
+				auto& dest = *m_pending[last].location.archetype;
+				const auto destRow = m_pending[last].location.row;
+
+				// The final archetype's columns are the current ones plus each new component, which went after any existing ones of the same type
+				// So columns of a type are filled from the current row first, then from the pending rows in the order they were reserved
+				unsigned sourceColumn = 0U;
+				unsigned nextPending = i;
+
+				for( unsigned column = 0U; column < dest.m_columns.size(); ++column )
+				{
+					const auto type = dest.m_signature[column];
+					void* source = nullptr;
+
+					if( location.archetype && sourceColumn < location.archetype->m_signature.size() && location.archetype->m_signature[sourceColumn] == type )
+					{
+						source = location.archetype->GetElement( location.row, sourceColumn++ );
+					}
+					else
+					{
+						while( m_pending[nextPending].object != object || m_pending[nextPending].location.archetype->m_signature[m_pending[nextPending].column] != type )
+							++nextPending;
+
+						const auto& pending = m_pending[nextPending++];
+
+						// The last new component was constructed in place
+						if( pending.location.archetype != &dest )
+							source = pending.location.archetype->GetElement( pending.location.row, pending.column );
+						else
+							assert( ( int )column == pending.column );
+					}
+
+					if( !source )
+						continue;
+
+					void* destData = dest.GetElement( destRow, column );
+					dest.m_columns[column]->relocate( destData, source );
+					m_handleManager.Update( destData, dest.m_columns[column]->toEntity( destData )->m_self );
+				}
+
+				if( location.archetype )
+					m_releasedRows.push_back( location );
+
+				for( unsigned j = i; j < last; ++j )
+					if( m_pending[j].object == object )
+						m_releasedRows.push_back( m_pending[j].location );
+
+				location = m_pending[last].location;
+			}
+
+			m_pending.clear();
+			m_pendingEnded = 0U;
+
+			// Highest rows first, so the row moved into each hole is never one still waiting to be released
+			std::sort( m_releasedRows.begin(), m_releasedRows.end(), []( const ArchetypeLocation& left, const ArchetypeLocation& right )
+			{
+				return left.archetype != right.archetype ? left.archetype < right.archetype : left.row > right.row;
+			} );
+
+			for( auto& released : m_releasedRows )
+				if( auto* moved = released.archetype->RemoveRow( released.row, m_handleManager ) )
+					moved->m_archetypeLocation.row = released.row;
+		}
+
+		void ArchetypeStorage::RemoveComponent( Object& object, const BaseHandle& component )
+		{
+			// Pending rows would be moved by RemoveRow before their components are constructed
+			assert( m_pending.empty() );
+
+			auto& location = object.m_archetypeLocation;
+			auto* current = location.archetype;
+			assert( current );
+
+			// Find which column holds this component
+			int removed = -1;
+			for( unsigned column = 0U; column < current->m_columns.size() && removed == -1; ++column )
+				if( current->m_columns[column]->toEntity( current->GetElement( location.row, column ) )->m_self == component )
+					removed = ( int )column;
+
+			assert( removed != -1 );
+			if( removed == -1 )
+				return;
+
+			current->m_columns[removed]->destroy( current->GetElement( location.row, removed ) );
+
+			auto signature = current->GetSignature();
+			signature.erase( signature.begin() + removed );
+
+			ArchetypeLocation newLocation;
+
+			if( !signature.empty() )
+			{
+				auto& dest = GetArchetype( signature );
+				newLocation.archetype = &dest;
+				newLocation.row = dest.AddRow( &object );
+				MoveRow( *current, location.row, dest, newLocation.row, removed, -1 );
+			}
+
+			if( auto* moved = current->RemoveRow( location.row, m_handleManager ) )
+				moved->m_archetypeLocation.row = location.row;
+
+			location = newLocation;
+		}
+
+		void ArchetypeStorage::RemoveObject( Object& object )
+		{
+			assert( m_pending.empty() );
+
+			auto& location = object.m_archetypeLocation;
+			auto* current = location.archetype;
+
+			if( !current )
+				return;
+
+			for( unsigned column = 0U; column < current->m_columns.size(); ++column )
+			{
+				void* data = current->GetElement( location.row, column );
+				const auto handle = current->m_columns[column]->toEntity( data )->m_self;
+				current->m_columns[column]->destroy( data );
+				m_handleManager.Remove( handle );
+			}
+
+			if( auto* moved = current->RemoveRow( location.row, m_handleManager ) )
+				moved->m_archetypeLocation.row = location.row;
+
+			location = ArchetypeLocation();
+		}
+
+		void ArchetypeStorage::OnObjectMoved( Object& object )
+		{
+			const auto& location = object.m_archetypeLocation;
+
+			if( location.archetype )
+				location.archetype->m_owners[location.row] = &object;
+		}
+
+		void ArchetypeStorage::Clear()
+		{
+			for( auto& archetype : m_archetypes )
+			{
+				auto& columns = archetype.second->m_columns;
+
+				for( unsigned row = 0U; row < archetype.second->Size(); ++row )
+				{
+					for( unsigned column = 0U; column < columns.size(); ++column )
+					{
+						void* data = archetype.second->GetElement( row, column );
+						const auto handle = columns[column]->toEntity( data )->m_self;
+						columns[column]->destroy( data );
+						m_handleManager.Remove( handle );
+					}
+				}
+
+				archetype.second->m_owners.clear();
+				archetype.second->m_chunks.clear();
+			}
+
+			m_archetypes.clear();
+		}
+	}
+}
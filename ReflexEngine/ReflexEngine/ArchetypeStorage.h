@@ -0,0 +1,210 @@
+#pragma once
+
+#include "Precompiled.h"
+#include "ComponentPool.h"
+#include "Component.h"
+#include "HandleFwd.hpp"
+
+#include <map>
+#include <cstring>
+#include <utility>
+
+namespace Reflex
+{
+	namespace Core
+	{
+		class Object;
+		class Archetype;
+
+		// Type erased operations required to store a component type in archetype chunks
+		struct ComponentTypeInfo
+		{
+			TypeId type = 0U;
+			unsigned size = 0U;
+			void( *relocate )( void* dest, void* src ) = nullptr;
+			void( *destroy )( void* data ) = nullptr;
+			Entity*( *toEntity )( void* data ) = nullptr;
+
+			template< class T >
+			static ComponentTypeInfo Create();
+		};
+
+		// Where an object's components currently live when using archetype storage
+		struct ArchetypeLocation
+		{
+			Archetype* archetype = nullptr;
+			unsigned row = 0U;
+		};
+
+		// Stores the components of every object with the same (sorted) list of component types
+		// Memory is split into fixed size chunks, each holding one contiguous column per component (SoA)
+		// Rows are kept dense by moving the last row into any removed row
+		class Archetype : private sf::NonCopyable
+		{
+		public:
+			friend class ArchetypeStorage;
+
+			Archetype( const std::vector< const ComponentTypeInfo* >& columns );
+			~Archetype();
+
+			const std::vector< TypeId >& GetSignature() const;
+			unsigned Size() const;
+			// Chunks holding at least one row (spare empty chunks aren't counted)
+			unsigned GetChunkCount() const;
+			unsigned GetChunkSize( const unsigned chunk ) const;
+
+			// Returns the first column holding the type, or -1 if this archetype doesn't contain it
+			int FindColumn( const TypeId type ) const;
+
+			// Start of a column within a chunk, valid for GetChunkSize( chunk ) elements
+			void* GetColumn( const unsigned chunk, const unsigned column ) const;
+			void* GetElement( const unsigned row, const unsigned column ) const;
+			Object* GetOwner( const unsigned row ) const;
+
+		private:
+			unsigned AddRow( Object* owner );
+
+			// Row must already be empty (components moved or destroyed), fills it with the last row
+			// Returns the owner of the row that was moved into the hole (nullptr if it was the last row)
+			Object* RemoveRow( const unsigned row, HandleManager& handleManager );
+
+			enum
+			{
+				ChunkSizeBytes = 16384,
+				ColumnAlignment = 16,
+				// Empty chunks kept around, so an object moving back and forth across a chunk boundary doesn't allocate every time
+				SpareChunks = 1,
+			};
+
+			std::vector< const ComponentTypeInfo* > m_columns;
+			std::vector< TypeId > m_signature;
+			std::vector< unsigned > m_columnOffsets;
+			std::vector< std::unique_ptr< char[] > > m_chunks;
+			std::vector< Object* > m_owners;
+			unsigned m_rowsPerChunk = 0U;
+			unsigned m_chunkBytes = 0U;
+		};
+
+		// Optional component storage for World, groups objects by their component signature so systems can iterate columns directly
+		// Adding or removing a component moves all of an object's components to another archetype (handles are kept in sync)
+		class ArchetypeStorage : private sf::NonCopyable
+		{
+		public:
+			ArchetypeStorage( HandleManager& handleManager );
+			~ArchetypeStorage();
+
+			template< class T >
+			void RegisterType();
+
+			// Reserves a row for the object in the archetype with an extra component of type and returns memory for the new component
+			// Nothing moves until EndAddComponent, so the new component can safely be constructed from an existing one
+			// Adds made while constructing (EG. from a component's constructor) nest, nothing moves until the outermost EndAddComponent
+			void* BeginAddComponent( Object& object, const TypeId type );
+			void EndAddComponent( Object& object );
+
+			// Destroys the component and moves the object to the archetype without it
+			void RemoveComponent( Object& object, const BaseHandle& component );
+
+			// Destroys all of the object's components (and their handles) at once, without moving it through the archetypes in between
+			void RemoveObject( Object& object );
+
+			// Keeps the archetype owner pointer up to date when the object itself is moved in memory
+			void OnObjectMoved( Object& object );
+
+			// Destroys every stored component and removes their handles
+			void Clear();
+
+			// Calls f( count, Ts*... ) for every chunk that contains all of the types, each pointer is the column of the first component of that type
+			template< typename... Ts, typename Func >
+			void ForEachChunk( const Func& f ) const;
+
+		private:
+			Archetype& GetArchetype( const std::vector< TypeId >& signature );
+			void FinishPendingAdds();
+			void MoveRow( Archetype& source, const unsigned sourceRow, Archetype& dest, const unsigned destRow, const int skipSource, const int skipDest );
+
+			template< typename... Ts, typename Func, size_t... Is >
+			static void CallChunk( const Archetype& archetype, const unsigned chunk, const int* columns, const Func& f, std::index_sequence< Is... > );
+
+		private:
+			HandleManager& m_handleManager;
+			// Indexed by component type id, boxed as archetypes hold pointers to these
+			std::vector< std::unique_ptr< ComponentTypeInfo > > m_types;
+			std::map< std::vector< TypeId >, std::unique_ptr< Archetype > > m_archetypes;
+
+			// Rows reserved by BeginAddComponent, in the order they were reserved
+			// Each holds only its new component until FinishPendingAdds moves everything into the object's last reserved row
+			struct PendingAdd
+			{
+				Object* object;
+				ArchetypeLocation location;
+				int column;
+			};
+
+			std::vector< PendingAdd > m_pending;
+			unsigned m_pendingEnded = 0U;
+
+			// Scratch for FinishPendingAdds, rows emptied by the moves
+			std::vector< ArchetypeLocation > m_releasedRows;
+		};
+
+		// Template definitions
+		template< class T >
+		ComponentTypeInfo ComponentTypeInfo::Create()
+		{
+			static_assert( alignof( T ) <= 16, "Archetype chunks only align columns to 16 bytes" );
+
+			ComponentTypeInfo info;
+			info.type = GetComponentTypeId< T >();
+			info.size = sizeof( T );
+			info.relocate = []( void* dest, void* src )
+			{
+				if constexpr( IsTriviallyRelocatable< T >::value )
+				{
+					std::memcpy( dest, src, sizeof( T ) );
+				}
+				else
+				{
+					new ( dest ) T( std::move( *( T* )src ) );
+					( ( T* )src )->~T();
+				}
+			};
+			info.destroy = []( void* data ) { ( ( T* )data )->~T(); };
+			info.toEntity = []( void* data ) -> Entity* { return ( T* )data; };
+			return info;
+		}
+
+		template< class T >
+		void ArchetypeStorage::RegisterType()
+		{
+			const auto type = GetComponentTypeId< T >();
+
+			if( type >= m_types.size() )
+				m_types.resize( type + 1 );
+
+			if( !m_types[type] )
+				m_types[type] = std::make_unique< ComponentTypeInfo >( ComponentTypeInfo::Create< T >() );
+		}
+
+		template< typename... Ts, typename Func >
+		void ArchetypeStorage::ForEachChunk( const Func& f ) const
+		{
+			for( auto& archetype : m_archetypes )
+			{
+				const int columns[] = { archetype.second->FindColumn( GetComponentTypeId< Ts >() )... };
+
+				if( std::find( std::begin( columns ), std::end( columns ), -1 ) != std::end( columns ) )
+					continue;
+
+				for( unsigned chunk = 0U; chunk < archetype.second->GetChunkCount(); ++chunk )
+					CallChunk< Ts... >( *archetype.second, chunk, columns, f, std::index_sequence_for< Ts... >() );
+			}
+		}
+
+		template< typename... Ts, typename Func, size_t... Is >
+		void ArchetypeStorage::CallChunk( const Archetype& archetype, const unsigned chunk, const int* columns, const Func& f, std::index_sequence< Is... > )
+		{
+			f( archetype.GetChunkSize( chunk ), ( Ts* )archetype.GetColumn( chunk, columns[Is] )... );
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#include "CommandBuffer.h"
+
+namespace Reflex
+{
+	namespace Core
+	{
+		CommandBuffer::ObjectRef CommandBuffer::CreateObject( const sf::Vector2f& position, const float rotation, const sf::Vector2f& scale )
+		{
+			ObjectRef object;
+			object.created = ( unsigned )m_creates.size();
+			m_creates.push_back( CreateCommand{ position, rotation, scale } );
+			return object;
+		}
+
+		void CommandBuffer::DestroyObject( const ObjectRef& object, const bool destroyChildren )
+		{
+			m_destroys.emplace_back( object, destroyChildren );
+		}
+
+		bool CommandBuffer::IsEmpty() const
+		{
+			return m_creates.empty() && m_adds.empty() && m_removes.empty() && m_destroys.empty();
+		}
+
+		void CommandBuffer::Clear()
+		{
+			m_creates.clear();
+			m_adds.clear();
+			m_removes.clear();
+			m_destroys.clear();
+		}
+
+		void CommandBuffer::Swap( CommandBuffer& other )
+		{
+			m_creates.swap( other.m_creates );
+			m_adds.swap( other.m_adds );
+			m_removes.swap( other.m_removes );
+			m_destroys.swap( other.m_destroys );
+		}
+
+		ObjectHandle CommandBuffer::Resolve( const ObjectRef& object, const std::vector< ObjectHandle >& created )
+		{
+			return object.created == NotCreated ? object.object : created[object.created];
+		}
+	}
+}
\ No newline at end of file
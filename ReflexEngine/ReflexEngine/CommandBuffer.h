@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Precompiled.h"
+#include "HandleFwd.hpp"
+#include "Component.h"
+
+#include <tuple>
+
+namespace Reflex
+{
+	namespace Core
+	{
+		// Records structural changes (creating / destroying objects, adding / removing components) to be applied later by World::PlaybackCommands
+		// Lets systems make these changes while iterating or while running in parallel, where changing the world directly isn't allowed
+		class CommandBuffer : private sf::NonCopyable
+		{
+		public:
+			friend class World;
+
+			// An object to apply a command to, either an existing object or one created earlier in the same buffer
+			struct ObjectRef
+			{
+				ObjectRef() { }
+				ObjectRef( const ObjectHandle& handle ) : object( handle ) { }
+
+				ObjectHandle object;
+				unsigned created = NotCreated;
+			};
+
+			ObjectRef CreateObject( const sf::Vector2f& position = sf::Vector2f(), const float rotation = 0.0f, const sf::Vector2f& scale = sf::Vector2f( 1.0f, 1.0f ) );
+			void DestroyObject( const ObjectRef& object, const bool destroyChildren = false );
+
+			// Arguments are copied into the buffer and the component is constructed from them on playback
+			template< class T, typename... Args >
+			void AddComponent( const ObjectRef& object, Args&&... args );
+
+			// Does nothing if the component is already gone
+			template< class T >
+			void RemoveComponent( const Handle< T >& component );
+
+			bool IsEmpty() const;
+			void Clear();
+
+		private:
+			enum : unsigned { NotCreated = 0xFFFFFFFF };
+
+			struct CreateCommand
+			{
+				sf::Vector2f position;
+				float rotation;
+				sf::Vector2f scale;
+			};
+
+			struct AddCommand
+			{
+				TypeId type;
+				ObjectRef object;
+				std::function< void( void* ) > construct;
+				// Applies a run of commands of the same type (see World::PlaybackAddComponents)
+				void( *playback )( World& world, AddCommand* begin, AddCommand* end, const std::vector< ObjectHandle >& created );
+			};
+
+			template< class T >
+			static void PlaybackAddComponents( World& world, AddCommand* begin, AddCommand* end, const std::vector< ObjectHandle >& created );
+
+			static ObjectHandle Resolve( const ObjectRef& object, const std::vector< ObjectHandle >& created );
+
+			// Exchanges recorded commands (and capacity) with another buffer
+			void Swap( CommandBuffer& other );
+
+		private:
+			std::vector< CreateCommand > m_creates;
+			std::vector< AddCommand > m_adds;
+			std::vector< std::pair< TypeId, BaseHandle > > m_removes;
+			std::vector< std::pair< ObjectRef, bool > > m_destroys;
+		};
+
+		// Template definitions (PlaybackAddComponents is defined in World.h)
+		template< class T, typename... Args >
+		void CommandBuffer::AddComponent( const ObjectRef& object, Args&&... args )
+		{
+			AddCommand command;
+			command.type = GetComponentTypeId< T >();
+			command.object = object;
+			command.construct = [arguments = std::tuple< std::decay_t< Args >... >( std::forward< Args >( args )... )]( void* memory ) mutable
+			{
+				std::apply( [memory]( auto&... values ) { new ( memory ) T( std::move( values )... ); }, arguments );
+			};
+			command.playback = &CommandBuffer::PlaybackAddComponents< T >;
+			m_adds.push_back( std::move( command ) );
+		}
+
+		template< class T >
+		void CommandBuffer::RemoveComponent( const Handle< T >& component )
+		{
+			// The type the component was created as, T may just be a base of it
+			if( component )
+				m_removes.emplace_back( component->GetTypeId(), component );
+		}
+	}
+}
\ No newline at end of file
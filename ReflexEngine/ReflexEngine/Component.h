@@ -3,6 +3,13 @@
 #include "Precompiled.h"
 #include "Entity.h"
 
+#include <bitset>
+
+// Can be raised by defining REFLEX_MAX_COMPONENT_TYPES for the whole build (signatures grow by one bit per type)
+#ifndef REFLEX_MAX_COMPONENT_TYPES
+	#define REFLEX_MAX_COMPONENT_TYPES 64
+#endif
+
 namespace Reflex
 {
 	using namespace Reflex::Core;
@@ -13,6 +20,30 @@ namespace Reflex
 	{
 		typedef Handle< class Reflex::Components::Component > ComponentHandle;
 		class World;
+
+		enum { MaxComponentTypes = REFLEX_MAX_COMPONENT_TYPES };
+		static_assert( MaxComponentTypes > 0, "REFLEX_MAX_COMPONENT_TYPES must be positive" );
+
+		// One bit per component type id, used to match objects against the components a system requires
+		typedef std::bitset< MaxComponentTypes > ComponentSignature;
+
+		// Fails in every build, an id past the limit would index outside of ComponentSignature
+		inline TypeId CheckComponentTypeId( const TypeId id )
+		{
+			if( id >= MaxComponentTypes )
+				THROW( "Component type id " << id << " exceeds the limit of " << MaxComponentTypes << " types, raise REFLEX_MAX_COMPONENT_TYPES" );
+
+			return id;
+		}
+
+		// Dense id for each component type, indexes the component pools, archetype columns and system requirements
+		template< class T >
+		TypeId GetComponentTypeId()
+		{
+			// Only checked the first time for each type
+			static const TypeId id = CheckComponentTypeId( TypeIdGenerator< Reflex::Components::Component >::Get< T >() );
+			return id;
+		}
 	}
 
 	namespace Components
@@ -28,12 +59,16 @@ namespace Reflex
 
 			virtual void SetOwningObject( const ObjectHandle& owner ) { m_object = owner; }
 
+			// Id of the most derived type this component was created as
+			TypeId GetTypeId() const { return m_typeId; }
+
 		protected:
 			Component() { }
 			virtual ~Component() { }
 
 		protected:
 			ObjectHandle m_object;
+			TypeId m_typeId = 0U;
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "EntityAllocator.h"
+
+#include <type_traits>
+
+namespace Reflex
+{
+	namespace Core
+	{
+		// Whether a type can be moved to a new address with a plain memcpy (and the old memory simply forgotten)
+		// Trivially copyable types are by default, other types can opt in with REFLEX_TRIVIALLY_RELOCATABLE( T )
+		// Only opt in types that don't hold pointers into themselves (std::function, debug std::vector, sf::Text etc. do)
+		template< class T >
+		struct IsTriviallyRelocatable : std::is_trivially_copyable< T > { };
+
+		// Typed pool, relocates elements with memcpy when T is trivially relocatable, otherwise with move-construct + destroy
+		template< class T >
+		class ComponentPool : public EntityAllocator
+		{
+		public:
+			ComponentPool( unsigned numElements, const GrowthMode mode = GrowthMode::Contiguous )
+				: EntityAllocator( sizeof( T ), numElements, mode )
+			{
+			}
+
+		protected:
+			void Relocate( void* dest, void* src, unsigned count ) final
+			{
+				if constexpr( IsTriviallyRelocatable< T >::value )
+				{
+					EntityAllocator::Relocate( dest, src, count );
+				}
+				else
+				{
+					T* destData = ( T* )dest;
+					T* srcData = ( T* )src;
+
+					for( unsigned i = 0U; i < count; ++i )
+					{
+						new ( destData + i ) T( std::move( srcData[i] ) );
+						srcData[i].~T();
+					}
+				}
+			}
+		};
+	}
+}
+
+// Must be used from the global namespace
+#define REFLEX_TRIVIALLY_RELOCATABLE( T ) \
+	namespace Reflex { namespace Core { template<> struct IsTriviallyRelocatable< T > : std::true_type { }; } }
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Precompiled.h"
+#include "Handle.h"
+
+#include <iterator>
+
+namespace Reflex
+{
+	namespace Systems
+	{
+		using Reflex::Core::BaseHandle;
+
+		class System;
+
+		// View of a single entry in a ComponentsTable, one handle per required component type of the system (in the order they were required)
+		// Only valid until entries are next added to or removed from the table
+		class ComponentsSet
+		{
+		public:
+			ComponentsSet() { }
+			ComponentsSet( BaseHandle* handles, const unsigned size ) : m_handles( handles ), m_size( size ) { }
+
+			BaseHandle& operator[]( const unsigned index ) const { return m_handles[index]; }
+			BaseHandle& front() const { return m_handles[0]; }
+			BaseHandle& back() const { return m_handles[m_size - 1U]; }
+			BaseHandle* begin() const { return m_handles; }
+			BaseHandle* end() const { return m_handles + m_size; }
+			unsigned size() const { return m_size; }
+			bool empty() const { return m_size == 0U; }
+
+			bool operator==( const ComponentsSet& other ) const { return m_size == other.m_size && std::equal( begin(), end(), other.begin() ); }
+			bool operator!=( const ComponentsSet& other ) const { return !( *this == other ); }
+
+		private:
+			BaseHandle* m_handles = nullptr;
+			unsigned m_size = 0U;
+		};
+
+		// Membership table of a system, every entry's handles are stored back to back in one array (stride = number of required component types)
+		// Iterating yields ComponentsSet views rather than owning containers, so entries cost no allocation of their own
+		class ComponentsTable
+		{
+		public:
+			friend class System;
+
+			class Iterator
+			{
+			public:
+				typedef std::random_access_iterator_tag iterator_category;
+				typedef ComponentsSet value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const ComponentsSet* pointer;
+				typedef const ComponentsSet& reference;
+
+				Iterator() { }
+				Iterator( BaseHandle* handles, const unsigned stride, const difference_type index ) : m_handles( handles ), m_stride( stride ), m_index( index ) { }
+
+				// The view lives in the iterator, so references remain valid for as long as the iterator does (as in a range based for)
+				reference operator*() const { m_view = ComponentsSet( m_handles + m_index * m_stride, m_stride ); return m_view; }
+				pointer operator->() const { return &**this; }
+				value_type operator[]( const difference_type offset ) const { return ComponentsSet( m_handles + ( m_index + offset ) * m_stride, m_stride ); }
+
+				Iterator& operator++() { ++m_index; return *this; }
+				Iterator& operator--() { --m_index; return *this; }
+				Iterator operator++( int ) { Iterator copy( *this ); ++m_index; return copy; }
+				Iterator operator--( int ) { Iterator copy( *this ); --m_index; return copy; }
+				Iterator& operator+=( const difference_type offset ) { m_index += offset; return *this; }
+				Iterator& operator-=( const difference_type offset ) { m_index -= offset; return *this; }
+				Iterator operator+( const difference_type offset ) const { return Iterator( m_handles, m_stride, m_index + offset ); }
+				Iterator operator-( const difference_type offset ) const { return Iterator( m_handles, m_stride, m_index - offset ); }
+				friend Iterator operator+( const difference_type offset, const Iterator& iter ) { return iter + offset; }
+				difference_type operator-( const Iterator& other ) const { return m_index - other.m_index; }
+
+				bool operator==( const Iterator& other ) const { return m_index == other.m_index; }
+				bool operator!=( const Iterator& other ) const { return m_index != other.m_index; }
+				bool operator<( const Iterator& other ) const { return m_index < other.m_index; }
+				bool operator>( const Iterator& other ) const { return m_index > other.m_index; }
+				bool operator<=( const Iterator& other ) const { return m_index <= other.m_index; }
+				bool operator>=( const Iterator& other ) const { return m_index >= other.m_index; }
+
+			private:
+				BaseHandle* m_handles = nullptr;
+				unsigned m_stride = 0U;
+				difference_type m_index = 0;
+				mutable ComponentsSet m_view;
+			};
+
+			typedef Iterator const_iterator;
+
+			unsigned size() const { return m_size; }
+			bool empty() const { return m_size == 0U; }
+			unsigned GetStride() const { return m_stride; }
+
+			ComponentsSet operator[]( const unsigned index ) const { return ComponentsSet( Data() + index * m_stride, m_stride ); }
+			ComponentsSet back() const { return ( *this )[m_size - 1U]; }
+
+			Iterator begin() const { return Iterator( Data(), m_stride, 0 ); }
+			Iterator end() const { return Iterator( Data(), m_stride, m_size ); }
+			Iterator cbegin() const { return begin(); }
+			Iterator cend() const { return end(); }
+
+			// Raw handles, entry i column k is at Data()[i * GetStride() + k]
+			BaseHandle* Data() const { return const_cast< BaseHandle* >( m_handles.data() ); }
+
+		private:
+			void SetStride( const unsigned stride )
+			{
+				assert( m_size == 0U || stride == m_stride );
+				m_stride = stride;
+			}
+
+			void Insert( const unsigned index, const BaseHandle* handles )
+			{
+				m_handles.insert( m_handles.begin() + index * m_stride, handles, handles + m_stride );
+				++m_size;
+			}
+
+			void Set( const unsigned index, const ComponentsSet& set )
+			{
+				std::copy( set.begin(), set.end(), m_handles.begin() + index * m_stride );
+			}
+
+			void Resize( const unsigned size )
+			{
+				m_handles.resize( size * m_stride );
+				m_size = size;
+			}
+
+			void PopBack() { Resize( m_size - 1U ); }
+			void Clear() { Resize( 0U ); }
+
+			void Swap( ComponentsTable& other )
+			{
+				m_handles.swap( other.m_handles );
+				std::swap( m_stride, other.m_stride );
+				std::swap( m_size, other.m_size );
+			}
+
+		private:
+			std::vector< BaseHandle > m_handles;
+			unsigned m_stride = 0U;
+			unsigned m_size = 0U;
+		};
+	}
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Precompiled.h"
 #include "ResourceManager.h"
 #include "HandleManager.h"
+#include "ThreadPool.h"
 
 namespace Reflex
 {
@@ -10,11 +11,12 @@ namespace Reflex
 	{
 		struct Context
 		{
-			Context( HandleManager& _handleManager, sf::RenderWindow& _window, TextureManager& _textureManager, FontManager& _fontManager )
+			Context( HandleManager& _handleManager, sf::RenderWindow& _window, TextureManager& _textureManager, FontManager& _fontManager, ThreadPool* _threadPool = nullptr )
 				: handleManager( &_handleManager )
 				, window( &_window )
 				, textureManager( &_textureManager )
 				, fontManager( &_fontManager )
+				, threadPool( _threadPool )
 			{
 			}
 
@@ -22,6 +24,8 @@ namespace Reflex
 			sf::RenderWindow* window;
 			TextureManager* textureManager;
 			FontManager* fontManager;
+			// Optional, without one worlds update their systems serially
+			ThreadPool* threadPool;
 		};
 	}
 }
\ No newline at end of file
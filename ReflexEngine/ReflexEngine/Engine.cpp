@@ -9,10 +9,11 @@ namespace Reflex
 		Engine::Engine()
 			: m_updateInterval( sf::seconds( 1.0f / 60.f ) )
 			, m_handleManager()
+			, m_threadPool()
 			, m_window( sf::VideoMode::getFullscreenModes()[0], "ReflexEngine", sf::Style::Default )
 			, m_textureManager()
 			, m_fontManager()
-			, m_stateManager( Context( m_handleManager, m_window, m_textureManager, m_fontManager ) )
+			, m_stateManager( Context( m_handleManager, m_window, m_textureManager, m_fontManager, &m_threadPool ) )
 		{
 			BaseHandle::s_handleManager = &m_handleManager;
 
@@ -38,6 +38,9 @@ namespace Reflex
 			// Handle manager which maps a handle to a void* in memory (such as in the above object allocator or a component allocator)
 			HandleManager m_handleManager;
 
+			// Worker threads shared by every world (systems are scheduled on these, see World::Update)
+			ThreadPool m_threadPool;
+
 			// Core window
 			sf::RenderWindow m_window;
 
@@ -8,18 +8,34 @@ namespace Reflex
 {
 	namespace Core
 	{
-		EntityAllocator::EntityAllocator( unsigned objectSize, unsigned numElements )
-			: m_array( malloc( objectSize * numElements ) )
-			, m_objectSize( objectSize )
+		EntityAllocator::EntityAllocator( unsigned objectSize, unsigned numElements, const GrowthMode mode /*= GrowthMode::Contiguous*/ )
+			: m_objectSize( objectSize )
 			, m_size( 0U )
-			, m_capacity( numElements )
+			, m_capacity( 0U )
+			, m_growthMode( mode )
 		{
+			if( m_growthMode == GrowthMode::Contiguous )
+			{
+				m_pages.push_back( malloc( objectSize * numElements ) );
+				m_capacity = numElements;
+				return;
+			}
 
+			// Pages hold a power of two number of elements so that an index can be split into page / offset with a shift and mask
+			const unsigned elementsPerPage = std::max( 1U, ( unsigned )PageSizeBytes / objectSize );
+			m_pageShift = 0U;
+			while( ( 1U << m_pageShift ) < elementsPerPage )
+				++m_pageShift;
+			m_pageMask = ( 1U << m_pageShift ) - 1U;
+
+			while( m_capacity < numElements )
+				AddPage();
 		}
 
 		EntityAllocator::~EntityAllocator()
 		{
-			free( m_array );
+			for( auto* page : m_pages )
+				free( page );
 		}
 
 		bool EntityAllocator::PreAllocate()
@@ -33,12 +49,31 @@ namespace Reflex
 			return false;
 		}
 
+		bool EntityAllocator::Reserve( const unsigned numElements )
+		{
+			if( m_size + numElements <= m_capacity )
+				return false;
+
+			if( m_growthMode == GrowthMode::Paged )
+			{
+				while( m_size + numElements > m_capacity )
+					AddPage();
+				return true;
+			}
+
+			m_capacity = std::max( m_capacity * 2 + 10, m_size + numElements );
+			m_arrayGrew = true;
+
+			GrowInteral();
+			return true;
+		}
+
 		void* EntityAllocator::Allocate()
 		{
 			if( m_size == m_capacity )
 				Grow();
 
-			return ( char * )m_array + m_size++ * m_objectSize;
+			return GetData( m_size++ );
 		}
 
 		void* EntityAllocator::Release( void* memory )
@@ -51,7 +86,7 @@ namespace Reflex
 					return nullptr;
 
 				Move( index, m_size );
-				return ( char * )m_array + index * m_objectSize;
+				return GetData( index );
 			}
 
 			return nullptr;
@@ -66,11 +101,12 @@ namespace Reflex
 			assert( b < m_size );
 
 			void* t = malloc( m_objectSize );
-			void* A = ( char * )m_array + a * m_objectSize;
-			void* B = ( char * )m_array + b * m_objectSize;
-			std::memcpy( t, A, m_objectSize );
-			std::memcpy( A, B, m_objectSize );
-			std::memcpy( B, t, m_objectSize );
+			void* A = GetData( a );
+			void* B = GetData( b );
+			Relocate( t, A, 1U );
+			Relocate( A, B, 1U );
+			Relocate( B, t, 1U );
+			free( t );
 		}
 
 		void EntityAllocator::Shrink()
@@ -117,13 +153,25 @@ namespace Reflex
 
 		unsigned EntityAllocator::GetIndex( void* data ) const
 		{
-			return ( ( char* )data - ( char* )m_array ) / m_objectSize;
+			if( m_growthMode == GrowthMode::Contiguous )
+				return ( unsigned )( ( ( char* )data - ( char* )m_pages[0] ) / m_objectSize );
+
+			// Find the page with the highest address which is still <= data
+			auto found = std::upper_bound( m_sortedPages.begin(), m_sortedPages.end(), ( char* )data, []( char* address, const std::pair< char*, unsigned >& page )
+			{
+				return address < page.first;
+			} );
+
+			assert( found != m_sortedPages.begin() );
+			--found;
+
+			return ( found->second << m_pageShift ) + ( unsigned )( ( ( char* )data - found->first ) / m_objectSize );
 		}
 
 		void* EntityAllocator::GetData( unsigned index ) const
 		{
-			assert( index < m_size );
-			return ( char* )m_array + index * m_objectSize;
+			assert( index < m_capacity );
+			return ( char* )m_pages[index >> m_pageShift] + ( index & m_pageMask ) * m_objectSize;
 		}
 
 		bool EntityAllocator::Grew() const
@@ -136,8 +184,25 @@ namespace Reflex
 			m_arrayGrew = false;
 		}
 
+		EntityAllocator::GrowthMode EntityAllocator::GetGrowthMode() const
+		{
+			return m_growthMode;
+		}
+
+		unsigned EntityAllocator::GetPageCapacity() const
+		{
+			return m_growthMode == GrowthMode::Contiguous ? m_capacity : m_pageMask + 1U;
+		}
+
 		void EntityAllocator::Grow()
 		{
+			// Paged growth never moves existing objects, so handles don't need to be re-synced
+			if( m_growthMode == GrowthMode::Paged )
+			{
+				AddPage();
+				return;
+			}
+
 			m_capacity = m_capacity ? ( m_capacity * 2 + 10 ) : 4;
 			m_arrayGrew = true;
 
@@ -146,13 +211,53 @@ namespace Reflex
 
 		void EntityAllocator::GrowInteral()
 		{
+			if( m_growthMode == GrowthMode::Paged )
+			{
+				ReleasePages();
+				return;
+			}
+
 			void* newArray = malloc( m_objectSize * m_capacity );
 
-			std::memcpy( newArray, m_array, m_size * m_objectSize );
+			Relocate( newArray, m_pages[0], m_size );
+
+			free( m_pages[0] );
+
+			m_pages[0] = newArray;
+		}
+
+		void EntityAllocator::AddPage()
+		{
+			const unsigned pageCapacity = m_pageMask + 1U;
+			auto* page = ( char* )malloc( m_objectSize * pageCapacity );
+
+			const auto pageEntry = std::make_pair( page, ( unsigned )m_pages.size() );
+			m_sortedPages.insert( std::upper_bound( m_sortedPages.begin(), m_sortedPages.end(), pageEntry ), pageEntry );
+
+			m_pages.push_back( page );
+			m_capacity += pageCapacity;
+		}
+
+		void EntityAllocator::ReleasePages()
+		{
+			// Free whole pages from the back which aren't required to hold the requested capacity (or the live elements)
+			const unsigned pageCapacity = m_pageMask + 1U;
+			const unsigned required = std::max( m_capacity, m_size );
+			const unsigned pagesRequired = ( required + pageCapacity - 1U ) / pageCapacity;
 
-			free( m_array );
+			while( m_pages.size() > pagesRequired )
+			{
+				const unsigned pageIndex = ( unsigned )m_pages.size() - 1U;
+				m_sortedPages.erase( std::find_if( m_sortedPages.begin(), m_sortedPages.end(), [pageIndex]( const std::pair< char*, unsigned >& page )
+				{
+					return page.second == pageIndex;
+				} ) );
+
+				free( m_pages.back() );
+				m_pages.pop_back();
+			}
 
-			m_array = newArray;
+			m_capacity = ( unsigned )m_pages.size() * pageCapacity;
 		}
 
 		void EntityAllocator::Move( unsigned dest, unsigned src )
@@ -160,9 +265,14 @@ namespace Reflex
 			if( dest == src )
 				return;
 
-			void* destPtr = ( char * )m_array + dest * m_objectSize;
-			void* srcPtr = ( char * )m_array + src * m_objectSize;
-			std::memcpy( destPtr, srcPtr, m_objectSize );
+			void* destPtr = GetData( dest );
+			void* srcPtr = GetData( src );
+			Relocate( destPtr, srcPtr, 1U );
+		}
+
+		void EntityAllocator::Relocate( void* dest, void* src, unsigned count )
+		{
+			std::memcpy( dest, src, count * m_objectSize );
 		}
 	}
-}
\ No newline at end of file
+}
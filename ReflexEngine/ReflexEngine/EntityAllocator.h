@@ -10,12 +10,23 @@ namespace Reflex
 		class EntityAllocator : private sf::NonCopyable
 		{
 		public:
-			EntityAllocator( unsigned objectSize, unsigned numElements );
-			~EntityAllocator();
+			// Contiguous: a single block which is reallocated (and moved) when it runs out of space
+			// Paged: fixed size pages which are never moved, growth just adds a new page
+			enum class GrowthMode : char
+			{
+				Contiguous,
+				Paged,
+			};
+
+			EntityAllocator( unsigned objectSize, unsigned numElements, const GrowthMode mode = GrowthMode::Contiguous );
+			virtual ~EntityAllocator();
 
 			// Allocates new capacity if required, but does not actually create a new object*, returns whether new space was allocated
 			bool PreAllocate();
 
+			// Allocates enough capacity for numElements more objects up front, returns whether new space was allocated
+			bool Reserve( const unsigned numElements );
+
 			// Allocate space and return index
 			void* Allocate();
 
@@ -38,28 +49,51 @@ namespace Reflex
 			void* GetData( unsigned index ) const;
 			bool Grew() const;
 			void ClearGrewFlag();
+			GrowthMode GetGrowthMode() const;
+			unsigned GetPageCapacity() const;
 
 			// Operator overloads for accessing the data
 			void* operator[]( unsigned index );
 			const void* operator[]( unsigned index ) const;
 
 			template< class T >
-			inline typename ArrayIterator< T > begin() { return ArrayIterator< T >( ( T* )m_array ); }
+			inline PagedIterator< T > begin() { return PagedIterator< T >( &m_pages, 0U, m_pageShift, m_pageMask ); }
 			template< class T >
-			inline typename ArrayIterator< T > end() { return ArrayIterator< T >( ( T* )m_array + m_size ); }
+			inline PagedIterator< T > end() { return PagedIterator< T >( &m_pages, m_size, m_pageShift, m_pageMask ); }
+
+		protected:
+			// Moves count elements from src into the uninitialised memory at dest, leaving the source elements destroyed
+			// The base allocator has no type information so this is a raw memcpy, typed pools override it (see ComponentPool)
+			virtual void Relocate( void* dest, void* src, unsigned count );
 
 		private:
 			void Grow();
 			void GrowInteral();
+			void AddPage();
+			void ReleasePages();
 			void Move( unsigned dest, unsigned src );
 
 			EntityAllocator() = delete;
 
 		private:
-			void* m_array = nullptr;
+			enum
+			{
+				PageSizeBytes = 16384,
+				ContiguousPageShift = 31,
+			};
+
+			// Contiguous mode only ever has a single page (which grows), paged mode has many fixed size pages
+			std::vector< void* > m_pages;
+
+			// Pages sorted by address, used to map a pointer back to an index in paged mode
+			std::vector< std::pair< char*, unsigned > > m_sortedPages;
+
 			unsigned m_objectSize = 0U;
 			unsigned m_size = 0U;
 			unsigned m_capacity = 0U;
+			unsigned m_pageShift = ContiguousPageShift;
+			unsigned m_pageMask = ( 1U << ContiguousPageShift ) - 1U;
+			GrowthMode m_growthMode = GrowthMode::Contiguous;
 			bool m_arrayGrew = false;
 		};
 	}
@@ -129,5 +129,142 @@ namespace Reflex
 		{
 			return m_data < rhs.m_data;
 		}
+
+		// Iterator over an allocator which stores its elements in a number of fixed size pages
+		// The index is split into a page index (upper bits) and an offset into the page (lower bits)
+		template< class T >
+		class PagedIterator : public std::iterator< std::random_access_iterator_tag, T >
+		{
+		public:
+			PagedIterator();
+			PagedIterator( const std::vector< void* >* pages, unsigned index, unsigned pageShift, unsigned pageMask );
+
+			T& operator*( void ) const;
+			T* operator->( void ) const;
+			PagedIterator& operator++( void );
+			PagedIterator& operator--( void );
+			PagedIterator operator++( int );
+			PagedIterator operator--( int );
+			PagedIterator operator+( int x ) const;
+			PagedIterator operator-( int x ) const;
+			unsigned operator-( const PagedIterator& rhs ) const;
+			PagedIterator& operator+=( int x );
+			PagedIterator& operator-=( int x );
+			bool operator<( const PagedIterator& rhs ) const;
+			bool operator==( const PagedIterator& rhs ) const;
+			bool operator!=( const PagedIterator& rhs ) const;
+
+		private:
+			const std::vector< void* >* m_pages;
+			unsigned m_index;
+			unsigned m_pageShift;
+			unsigned m_pageMask;
+		};
+
+		template< typename T >
+		PagedIterator< T >::PagedIterator()
+			: m_pages( nullptr )
+			, m_index( 0U )
+			, m_pageShift( 0U )
+			, m_pageMask( 0U )
+		{
+		}
+
+		template< typename T >
+		PagedIterator< T >::PagedIterator( const std::vector< void* >* pages, unsigned index, unsigned pageShift, unsigned pageMask )
+			: m_pages( pages )
+			, m_index( index )
+			, m_pageShift( pageShift )
+			, m_pageMask( pageMask )
+		{
+		}
+
+		template< typename T >
+		T& PagedIterator< T >::operator*() const
+		{
+			return *( ( T* )( *m_pages )[m_index >> m_pageShift] + ( m_index & m_pageMask ) );
+		}
+
+		template< typename T >
+		T* PagedIterator< T >::operator->() const
+		{
+			return ( T* )( *m_pages )[m_index >> m_pageShift] + ( m_index & m_pageMask );
+		}
+
+		template< typename T >
+		PagedIterator< T >& PagedIterator< T >::operator++()
+		{
+			++m_index;
+			return *this;
+		}
+
+		template< typename T >
+		PagedIterator< T >& PagedIterator< T >::operator--()
+		{
+			--m_index;
+			return *this;
+		}
+
+		template< typename T >
+		PagedIterator< T > PagedIterator< T >::operator++( int )
+		{
+			return PagedIterator( m_pages, m_index++, m_pageShift, m_pageMask );
+		}
+
+		template< typename T >
+		PagedIterator< T > PagedIterator< T >::operator--( int )
+		{
+			return PagedIterator( m_pages, m_index--, m_pageShift, m_pageMask );
+		}
+
+		template< typename T >
+		bool PagedIterator< T >::operator==( const PagedIterator &rhs ) const
+		{
+			return m_index == rhs.m_index && m_pages == rhs.m_pages;
+		}
+
+		template< typename T >
+		bool PagedIterator< T >::operator!=( const PagedIterator &rhs ) const
+		{
+			return !( *this == rhs );
+		}
+
+		template< typename T >
+		PagedIterator< T > PagedIterator< T >::operator+( int x ) const
+		{
+			return PagedIterator( m_pages, m_index + x, m_pageShift, m_pageMask );
+		}
+
+		template< typename T >
+		PagedIterator< T > PagedIterator< T >::operator-( int x ) const
+		{
+			return PagedIterator( m_pages, m_index - x, m_pageShift, m_pageMask );
+		}
+
+		template< typename T >
+		unsigned PagedIterator< T >::operator-( const PagedIterator& rhs ) const
+		{
+			return m_index - rhs.m_index;
+		}
+
+		template< typename T >
+		PagedIterator< T >& PagedIterator< T >::operator+=( int x )
+		{
+			m_index += x;
+			return *this;
+		}
+
+		template< typename T >
+		PagedIterator< T >& PagedIterator< T >::operator-=( int x )
+		{
+			m_index -= x;
+			return *this;
+		}
+
+		template< typename T >
+		bool PagedIterator< T >::operator<( const PagedIterator& rhs ) const
+		{
+			return m_index < rhs.m_index;
+		}
 	}
 }
\ No newline at end of file
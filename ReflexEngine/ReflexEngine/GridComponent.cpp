@@ -35,17 +35,12 @@ namespace Reflex
 				return;
 			}
 			
-			auto transform = handle->GetTransform();
-
-			if( transform->m_parent )
-				transform->m_parent->GetTransform()->DetachChild( handle );
+			// Linked in like any other child so the grid's movement reaches the cells' world transforms
+			GetObject()->GetTransform()->AttachChild( handle );
 
 			const auto insertIndex = GetIndex( index );
 			m_children[insertIndex] = handle;
-			transform->m_parent = GetObject();
-			transform->SetZOrder( SceneNode::s_nextRenderIndex++ );
-			transform->SetLayer( GetObject()->GetTransform()->m_layerIndex + 1 );
-			transform->setPosition( GetCellPositionRelative( index ) );
+			handle->GetTransform()->setPosition( GetCellPositionRelative( index ) );
 		}
 
 		ObjectHandle Grid::RemoveFromGrid( const unsigned x, const unsigned y )
@@ -159,18 +154,24 @@ namespace Reflex
 
 		sf::Vector2f Grid::GetCellPositionWorld( const sf::Vector2u index ) const
 		{
-			const auto transform = GetObject()->GetTransform();
-			const auto gridCentre = transform->GetWorldPosition();
-			const auto worldPosition = GetCellPositionRelative( index ) + gridCentre;
-			return Reflex::RotateAroundPoint( worldPosition, gridCentre, transform->GetWorldRotation() );
+			return GetCellToWorld().TransformPoint( GetCellPositionRelative( index ) );
+		}
+
+		void Grid::GetCellPositionsWorld( std::vector< sf::Vector2f >& out ) const
+		{
+			out.resize( GetTotalCells() );
+
+			for( unsigned i = 0U; i < out.size(); ++i )
+				out[i] = GetCellPositionRelative( GetCoords( i ) );
+
+			Reflex::TransformPoints( GetCellToWorld(), out.data(), out.data(), ( unsigned )out.size() );
 		}
 
 		std::pair< bool, sf::Vector2u > Grid::GetCellIndex( const sf::Vector2f worldPosition, bool rotated ) const
 		{
-			const auto transform = GetObject()->GetTransform();
-			const auto gridCentre = transform->GetWorldPosition();
-			const auto correctedPosition = rotated ? Reflex::RotateAroundPoint( worldPosition, gridCentre, -transform->GetWorldRotation() ) : worldPosition;
-			const auto localPosition = correctedPosition - ( GetCellPositionRelative( sf::Vector2u( 0U, 0U ) ) + gridCentre ); // Scale??
+			const auto gridCentre = GetObject()->GetTransform()->GetWorldPosition();
+			const auto relativePosition = rotated ? GetCellToWorld().GetInverse().TransformPoint( worldPosition ) : worldPosition - gridCentre;
+			const auto localPosition = relativePosition - GetCellPositionRelative( sf::Vector2u( 0U, 0U ) ); // Scale??
 			const auto indexX = RoundToInt( localPosition.x / m_cellSize.x );
 			const auto indexY = RoundToInt( localPosition.y / m_cellSize.y );
 			const auto valid = indexX >= 0 && indexX < ( int )GetWidth() && indexY >= 0 && indexY < ( int )GetHeight();
@@ -179,8 +180,11 @@ namespace Reflex
 
 		std::pair< bool, sf::Vector2u > Grid::ConvertCellIndex( const sf::Vector2u index, const bool rotate ) const
 		{
-			const auto rotation = GetObject()->GetTransform()->GetWorldRotation();
-			const auto rotatedIndex = Reflex::RotateAroundPoint( Reflex::Vector2uToVector2i( index ), sf::Vector2i( 1, 1 ), rotate ? -rotation : rotation );
+			// Rotated about ( 1, 1 ), backwards when rotate is set (the inverse of a rotation is just its transpose)
+			const auto& rotation = GetRotation();
+			const auto offset = Reflex::Vector2uToVector2f( index ) - sf::Vector2f( 1.0f, 1.0f );
+			const auto rotatedOffset = rotate ? sf::Vector2f( rotation.a * offset.x + rotation.c * offset.y, rotation.b * offset.x + rotation.d * offset.y ) : rotation.TransformVector( offset );
+			const auto rotatedIndex = Reflex::Vector2fToVector2i( sf::Vector2f( 1.0f, 1.0f ) + rotatedOffset );
 			const auto valid = rotatedIndex.x >= 0 && rotatedIndex.x < ( int )GetWidth() && rotatedIndex.y >= 0 && rotatedIndex.y < ( int )GetHeight();
 			return std::make_pair( valid, Reflex::Vector2iToVector2u( rotatedIndex ) );
 		}
@@ -201,6 +205,28 @@ namespace Reflex
 			return sf::Vector2u( index % GetWidth(), index / GetWidth() );
 		}
 
+		Reflex::Affine2D Grid::GetCellToWorld() const
+		{
+			auto cellToWorld = GetRotation();
+			const auto gridCentre = GetObject()->GetTransform()->GetWorldPosition();
+			cellToWorld.x = gridCentre.x;
+			cellToWorld.y = gridCentre.y;
+			return cellToWorld;
+		}
+
+		const Reflex::Affine2D& Grid::GetRotation() const
+		{
+			const auto rotation = GetObject()->GetTransform()->GetWorldRotation();
+
+			if( rotation != m_rotationDegrees )
+			{
+				m_rotationDegrees = rotation;
+				m_rotation = Reflex::Affine2D::Rotation( rotation );
+			}
+
+			return m_rotation;
+		}
+
 		void Grid::UpdateGridPositions()
 		{
 			for( unsigned y = 0U; y < GetHeight(); ++y )
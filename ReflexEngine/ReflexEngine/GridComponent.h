@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Component.h"
+#include "Affine2D.h"
 
 namespace Reflex
 {
@@ -48,6 +49,9 @@ namespace Reflex
 			std::pair< bool, sf::Vector2u > GetCellIndex( const sf::Vector2f worldPosition, bool rotated = true ) const;
 			std::pair< bool, sf::Vector2u > ConvertCellIndex( const sf::Vector2u index, const bool rotate ) const;
 
+			// World position of every cell, out[GetIndex( index )] is the position of the cell at index
+			void GetCellPositionsWorld( std::vector< sf::Vector2f >& out ) const;
+
 			void ForEachChild( std::function< void( const ObjectHandle& obj, const sf::Vector2u index ) > callback );
 
 		protected:
@@ -55,11 +59,19 @@ namespace Reflex
 			const sf::Vector2u GetCoords( const unsigned index ) const;
 			void UpdateGridPositions();
 
+			// Maps cell positions relative to the grid into world space (the grid's world rotation about its world position)
+			Reflex::Affine2D GetCellToWorld() const;
+			// Rotation part of the above, the sine and cosine are only recalculated when the grid's world rotation changes
+			const Reflex::Affine2D& GetRotation() const;
+
 		private:
 			Reflex::VectorSet< ObjectHandle > m_children;
 			sf::Vector2u m_gridSize;
 			sf::Vector2f m_cellSize;
 			bool m_centreGrid = true;
+
+			mutable Reflex::Affine2D m_rotation;
+			mutable float m_rotationDegrees = 0.0f;
 		};
 	}
 }
\ No newline at end of file
@@ -11,8 +11,8 @@ namespace Reflex
 		BaseHandle BaseHandle::null;
 
 		BaseHandle::BaseHandle()
-			: m_index( -1 )
-			, m_counter( -1 )
+			: m_index( 0xFFFFFFFF )
+			, m_counter( 0xFFFFFFFF )
 		{
 		}
 
@@ -33,9 +33,9 @@ namespace Reflex
 			return IsValid();
 		}
 
-		BaseHandle::operator unsigned() const
+		BaseHandle::operator uint64_t() const
 		{
-			return m_counter << 16 | m_index;
+			return uint64_t( m_counter ) << 32 | m_index;
 		}
 
 		bool BaseHandle::operator==( const BaseHandle& other ) const
@@ -50,7 +50,10 @@ namespace Reflex
 
 		bool BaseHandle::IsValid() const
 		{
-			return m_index != null.m_index && m_counter != null.m_counter;
+			if( m_index == null.m_index || m_counter == null.m_counter )
+				return false;
+
+			return s_handleManager && s_handleManager->IsValid( *this );
 		}
 	}
 }
\ No newline at end of file
@@ -16,15 +16,16 @@ namespace Reflex
 		//	BaseHandle( uint32_t handle );
 
 			explicit operator bool() const;
-			operator unsigned() const;
+			// Orders by counter then index, also usable as a unique 64 bit key
+			operator uint64_t() const;
 			bool operator==( const BaseHandle& other ) const;
 			bool operator!=( const BaseHandle& other ) const;
-			virtual bool IsValid() const;
+			// Checks the handle still refers to a live entry in the handle manager
+			bool IsValid() const;
 
 			// Members
-			uint32_t m_index : 16;
-			uint32_t m_counter : 16;
-			bool markedForDeletion = false;
+			uint32_t m_index;
+			uint32_t m_counter;
 
 			static BaseHandle null;
 			static class HandleManager* s_handleManager;
@@ -38,7 +39,6 @@ namespace Reflex
 			Handle( const BaseHandle& handle );
 			T* Get() const;
 			T* operator->() const;
-			bool IsValid() const final;
 
 			template< class V >
 			Handle( const Handle< V >& handle ) = delete;
@@ -12,6 +12,10 @@ namespace Reflex
 		// Forward declaration of common handle types
 		typedef Handle< class Object > ObjectHandle;
 
+		// Handles are stored by value in most engine containers, keep them small and memcpy-able
+		static_assert( sizeof( BaseHandle ) == 8, "BaseHandle should be two 32 bit values" );
+		static_assert( std::is_trivially_copyable< BaseHandle >::value, "BaseHandle should be trivially copyable" );
+
 		// Template functions
 		template< class T >
 		Handle< T >::Handle( const BaseHandle& handle )
@@ -31,12 +35,6 @@ namespace Reflex
 		{
 			return Get();
 		}
-		
-		template< class T >
-		bool Handle< T >::IsValid() const
-		{
-			return BaseHandle::IsValid() && Get();
-		}
 	}
 }
 
@@ -48,7 +46,7 @@ namespace std
 	{
 		std::size_t operator()( const Reflex::Core::BaseHandle& k ) const
 		{
-			return hash< uint32_t >()( k.m_index ) ^ ( hash< uint32_t >()( k.m_counter ) >> 1 );
+			return hash< uint64_t >()( uint64_t( k.m_counter ) << 32 | k.m_index );
 		}
 	};
 
@@ -57,7 +55,7 @@ namespace std
 	{
 		std::size_t operator()( const Reflex::Core::Handle< T >& k ) const
 		{
-			return hash< uint32_t >()( k.m_index ) ^ ( hash< uint32_t >()( k.m_counter ) >> 1 );
+			return hash< uint64_t >()( uint64_t( k.m_counter ) << 32 | k.m_index );
 		}
 	};
 }
\ No newline at end of file
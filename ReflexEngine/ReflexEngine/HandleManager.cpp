@@ -5,25 +5,24 @@ namespace Reflex
 	namespace Core
 	{
 		HandleManager::HandleManager()
-			: m_freeSlots( m_MaxEntries )
-			, m_freeList( 0 )
+			: m_capacity( 0U )
+			, m_freeSlots( 0U )
+			, m_freeList( EndOfList )
 		{
 			Clear();
 		}
 
 		HandleManager::HandleEntry::HandleEntry()
-			: m_nextFreeIndex( 0 )
+			: m_nextFreeIndex( EndOfList )
 			, m_counter( 0 )
-			, m_endOfList( false )
 			, m_allocated( false )
 			, m_ptr( NULL )
 		{
 		}
 
-		HandleManager::HandleEntry::HandleEntry( unsigned nextFreeIndex )
+		HandleManager::HandleEntry::HandleEntry( uint32_t nextFreeIndex )
 			: m_nextFreeIndex( nextFreeIndex )
 			, m_counter( 0 )
-			, m_endOfList( false )
 			, m_allocated( false )
 			, m_ptr( NULL )
 		{
@@ -31,20 +30,41 @@ namespace Reflex
 
 		void HandleManager::Clear( void )
 		{
-			// Link free slots together
-			for( unsigned i = 0; i < m_MaxEntries - 1; ++i )
-				m_array[i] = HandleEntry( i + 1 );
-			m_array[m_MaxEntries - 1].m_endOfList = true;
+			m_pages.clear();
+			m_capacity = 0U;
+			m_freeSlots = 0U;
+			m_freeList = EndOfList;
 
-			m_freeSlots = m_MaxEntries;
+			AddPage();
+		}
+
+		void HandleManager::AddPage()
+		{
+			// Index range is 32 bit, and the top value is reserved for BaseHandle::null
+			assert( m_capacity <= EndOfList - PageSize );
+
+			const uint32_t first = m_capacity;
+			std::unique_ptr< HandleEntry[] > page( new HandleEntry[PageSize] );
+
+			// Link free slots together, the last one continues onto the existing free list
+			for( uint32_t i = 0U; i < PageSize - 1U; ++i )
+				page[i] = HandleEntry( first + i + 1U );
+			page[PageSize - 1U] = HandleEntry( m_freeList );
+
+			m_pages.push_back( std::move( page ) );
+			m_freeList = first;
+			m_capacity += PageSize;
+			m_freeSlots += PageSize;
 		}
 
 		BaseHandle HandleManager::Insert( void* ptr )
 		{
-			HandleEntry* entry = m_array.data() + m_freeList;
+			// No more free entries, grow by a page (existing entries stay where they are)
+			if( m_freeList == EndOfList )
+				AddPage();
 
-			// No more free entries
-			assert( !entry->m_endOfList );
+			const uint32_t index = m_freeList;
+			HandleEntry* entry = GetEntry( index );
 
 			// Cannot insert into an allocated location
 			assert( !entry->m_allocated );
@@ -52,8 +72,7 @@ namespace Reflex
 			entry->m_allocated = true;
 
 			// Increment freeList
-			unsigned index = m_freeList;
-			m_freeList = m_array[m_freeList].m_nextFreeIndex;
+			m_freeList = entry->m_nextFreeIndex;
 
 			// Insert ptr into entry
 			entry->m_ptr = ptr;
@@ -66,20 +85,23 @@ namespace Reflex
 		{
 			assert( handle.IsValid() );
 
-			HandleEntry* entry = m_array.data() + handle.m_index;
+			HandleEntry* entry = GetEntry( handle.m_index );
 
-			assert( entry->m_allocated );
+			assert( entry && entry->m_allocated );
 
 			entry->m_ptr = ptr;
 		}
 
 		void HandleManager::Remove( const BaseHandle& handle )
 		{
-			HandleEntry* entry = m_array.data() + handle.m_index;
+			HandleEntry* entry = GetEntry( handle.m_index );
 
-			assert( entry->m_allocated );
+			assert( entry && entry->m_allocated );
+
+			// Skip the null counter value so a recycled entry can never produce a handle that looks null
+			if( ++entry->m_counter == BaseHandle::null.m_counter )
+				++entry->m_counter;
 
-			entry->m_counter++;
 			entry->m_allocated = false;
 
 			// Push removed slot onto freeList
@@ -91,9 +113,9 @@ namespace Reflex
 
 		void* HandleManager::Get( const BaseHandle& handle ) const
 		{
-			const HandleEntry* entry = m_array.data() + handle.m_index;
+			const HandleEntry* entry = GetEntry( handle.m_index );
 
-			if( entry->m_counter == handle.m_counter && entry->m_allocated )
+			if( entry && entry->m_counter == handle.m_counter && entry->m_allocated )
 				return entry->m_ptr;
 
 			return NULL;
@@ -101,9 +123,9 @@ namespace Reflex
 
 		bool HandleManager::IsValid( const BaseHandle& handle ) const
 		{
-			const HandleEntry* entry = m_array.data() + handle.m_index;
+			const HandleEntry* entry = GetEntry( handle.m_index );
 
-			if( entry->m_counter == handle.m_counter && entry->m_allocated )
+			if( entry && entry->m_counter == handle.m_counter && entry->m_allocated )
 				return true;
 
 			return false;
@@ -111,13 +133,16 @@ namespace Reflex
 
 		void HandleManager::Replace( void* ptr, BaseHandle& handle )
 		{
-			HandleEntry* entry = m_array.data() + handle.m_index;
+			HandleEntry* entry = GetEntry( handle.m_index );
+
+			assert( entry );
 
 			// Increment the uid counter to signify a new handle at
 			// this entry
 			if( entry->m_allocated )
 			{
-				entry->m_counter++;
+				if( ++entry->m_counter == BaseHandle::null.m_counter )
+					++entry->m_counter;
 				handle.m_counter = entry->m_counter;
 			}
 
@@ -128,5 +153,10 @@ namespace Reflex
 		{
 			return m_freeSlots;
 		}
+
+		unsigned HandleManager::Capacity() const
+		{
+			return m_capacity;
+		}
 	}
 }
\ No newline at end of file
@@ -3,8 +3,6 @@
 #include "Precompiled.h"
 #include "Handle.h"
 
-#include <array>
-
 namespace Reflex
 {
 	namespace Core
@@ -37,26 +35,52 @@ namespace Reflex
 
 			bool IsValid( const BaseHandle& handle ) const;
 
+			// Resolves count handles (each stride handles apart) into out, invalid handles resolve to nullptr
+			// Entries are prefetched ahead of use and the resolved objects are prefetched for the caller
+			template< class T >
+			void ResolveBatch( const BaseHandle* handles, const unsigned count, T** out, const unsigned stride = 1U ) const;
+
 			unsigned FreeSlots() const;
+			unsigned Capacity() const;
 
 		private:
 			struct HandleEntry
 			{
 				HandleEntry();
-				HandleEntry( unsigned nextFreeIndex );
+				HandleEntry( uint32_t nextFreeIndex );
 
-				unsigned m_nextFreeIndex : 16;
-				unsigned m_counter : 16;
-				unsigned m_endOfList : 1;
-				unsigned m_allocated : 1;
+				uint32_t m_nextFreeIndex;
+				uint32_t m_counter;
+				bool m_allocated;
 				void* m_ptr;
 			};
 
-			unsigned m_freeSlots;
-			unsigned m_freeList;
+			// Entries live in fixed size pages, growing only adds a page so live entries never move
+			// Returns nullptr for indices outside the table (such as BaseHandle::null)
+			HandleEntry* GetEntry( const uint32_t index ) const;
+			void AddPage();
+
+			// Cache hint only, does nothing without SSE
+			static void Prefetch( const void* address )
+			{
+#ifdef REFLEX_SSE
+				_mm_prefetch( ( const char* )address, _MM_HINT_T0 );
+#endif
+			}
 
-			enum { m_MaxEntries = 16384 };
-			std::array< HandleEntry, m_MaxEntries > m_array;
+			enum : uint32_t
+			{
+				PageShift = 12,
+				PageSize = 1U << PageShift,
+				PageMask = PageSize - 1U,
+				EndOfList = 0xFFFFFFFF,
+				PrefetchDistance = 8,
+			};
+
+			std::vector< std::unique_ptr< HandleEntry[] > > m_pages;
+			uint32_t m_capacity;
+			uint32_t m_freeSlots;
+			uint32_t m_freeList;
 		};
 
 		// Template definitions
@@ -72,15 +96,51 @@ namespace Reflex
 			Update( ptr, ptr->m_self );
 		}
 
+		inline HandleManager::HandleEntry* HandleManager::GetEntry( const uint32_t index ) const
+		{
+			if( index >= m_capacity )
+				return nullptr;
+
+			return m_pages[index >> PageShift].get() + ( index & PageMask );
+		}
+
 		template< class T >
 		T* HandleManager::GetAs( const Handle< T >& handle ) const
 		{
-			const HandleEntry* entry = m_array.data() + handle.m_index;
+			const HandleEntry* entry = GetEntry( handle.m_index );
 			
-			if( entry->m_counter == handle.m_counter && entry->m_allocated )
+			if( entry && entry->m_counter == handle.m_counter && entry->m_allocated )
 				return ( T* )entry->m_ptr;
 
 			return nullptr;
 		}
+
+		template< class T >
+		void HandleManager::ResolveBatch( const BaseHandle* handles, const unsigned count, T** out, const unsigned stride ) const
+		{
+			for( unsigned i = 0U; i < count && i < PrefetchDistance; ++i )
+				if( const auto* entry = GetEntry( handles[i * stride].m_index ) )
+					Prefetch( entry );
+
+			for( unsigned i = 0U; i < count; ++i )
+			{
+				if( i + PrefetchDistance < count )
+					if( const auto* entry = GetEntry( handles[( i + PrefetchDistance ) * stride].m_index ) )
+						Prefetch( entry );
+
+				const BaseHandle& handle = handles[i * stride];
+				const HandleEntry* entry = GetEntry( handle.m_index );
+
+				if( entry && entry->m_counter == handle.m_counter && entry->m_allocated )
+				{
+					out[i] = ( T* )entry->m_ptr;
+					Prefetch( out[i] );
+				}
+				else
+				{
+					out[i] = nullptr;
+				}
+			}
+		}
 	}
 }
\ No newline at end of file
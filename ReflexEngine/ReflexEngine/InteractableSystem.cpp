@@ -16,74 +16,99 @@ namespace Reflex
 			RequiresComponent( SFMLObject );
 		}
 
-		bool InteractableSystem::CheckCollision( const TransformHandle& transform, const sf::FloatRect& localBounds, const sf::Vector2f& mousePosition ) const
+		bool InteractableSystem::CheckCollision( const Transform& transform, const sf::Transformable& shape, const sf::FloatRect& localBounds, const sf::Vector2f& mousePosition ) const
 		{
-			sf::Transform transformFinal;
-			transformFinal.scale( transform->GetWorldScale() ).translate( transform->GetWorldTranslation() );
-			auto globalBounds = transformFinal.transformRect( localBounds );
-			globalBounds.left -= localBounds.width / 2.0f;
-			globalBounds.top -= localBounds.height / 2.0f;
-			return Reflex::BoundingBox( globalBounds, transform->GetWorldRotation() ).contains( mousePosition );
+			const auto toLocal = ( transform.GetWorldAffine() * Reflex::Affine2D::FromTransform( shape.getTransform() ) ).GetInverse();
+			return localBounds.contains( toLocal.TransformPoint( mousePosition ) );
 		}
 
-		void InteractableSystem::Update( const float deltaTime )
+		bool InteractableSystem::CheckCollision( const Transform& transform, const SFMLObject& sfmlObj, const sf::Vector2f& mousePosition ) const
 		{
-			const auto window = GetWorld().GetContext().window;
-			const auto mousePosition = window->mapPixelToCoords( sf::Mouse::getPosition( *window ) );
+			switch( sfmlObj.GetType() )
+			{
+			case SFMLObjectType::Circle:
+			{
+				// Tested in the circle's local space, where its centre is ( radius, radius )
+				const auto& circle = sfmlObj.GetCircleShape();
+				const auto toLocal = ( transform.GetWorldAffine() * Reflex::Affine2D::FromTransform( circle.getTransform() ) ).GetInverse();
+				return Reflex::Circle( sf::Vector2f( circle.getRadius(), circle.getRadius() ), circle.getRadius() ).Contains( toLocal.TransformPoint( mousePosition ) );
+			}
+			case SFMLObjectType::Rectangle:
+				return CheckCollision( transform, sfmlObj.GetRectangleShape(), sfmlObj.GetRectangleShape().getLocalBounds(), mousePosition );
+			case SFMLObjectType::Convex:
+				return CheckCollision( transform, sfmlObj.GetConvexShape(), sfmlObj.GetConvexShape().getLocalBounds(), mousePosition );
+			case SFMLObjectType::Sprite:
+				return CheckCollision( transform, sfmlObj.GetSprite(), sfmlObj.GetSprite().getLocalBounds(), mousePosition );
+			case SFMLObjectType::Text:
+				return CheckCollision( transform, sfmlObj.GetText(), sfmlObj.GetText().getLocalBounds(), mousePosition );
+			}
+
+			return false;
+		}
 
-			ForEachSystemComponent< Transform, Interactable, SFMLObject >(
-				[&]( const TransformHandle& transform, InteractableHandle& interactable, const SFMLObjectHandle& sfmlObj )
+		void InteractableSystem::UpdateInteraction( const InteractableHandle& interactable, const bool collision )
+		{
+			auto* ptr = interactable.Get();
+
+			// Focus / highlighting
+			if( ptr->isFocussed != collision )
 			{
-				auto* ptr = interactable.Get();
+				ptr->isFocussed = collision;
 
-				bool collision = false;
-				
-				// Collision with bounds
-				switch( sfmlObj->GetType() )
-				{
-				case SFMLObjectType::Circle:
-					collision = Reflex::Circle( transform->GetWorldPosition(), sfmlObj->GetCircleShape().getRadius() ).Contains( mousePosition );
-				break;
-				case SFMLObjectType::Rectangle:
-					collision = CheckCollision( transform, sfmlObj->GetRectangleShape().getLocalBounds(), mousePosition );
-				break;
-				case SFMLObjectType::Convex:
-					collision = CheckCollision( transform, sfmlObj->GetConvexShape().getLocalBounds(), mousePosition );
-				break;
-				case SFMLObjectType::Sprite:
-					collision = CheckCollision( transform, sfmlObj->GetSprite().getLocalBounds(), mousePosition );
-				break;
-				case SFMLObjectType::Text:
-					collision = CheckCollision( transform, sfmlObj->GetText().getLocalBounds(), mousePosition );
-				break;
-				}
+				if( !collision && ptr->focusChangedCallback )
+					ptr->focusChangedCallback( interactable, false );
+				else if( collision && ptr->focusChangedCallback )
+					ptr->focusChangedCallback( interactable, true );
 
-				// Focus / highlighting
-				if( ptr->isFocussed != collision )
-				{
-					ptr->isFocussed = collision;
+				// Lost highlight, then we also unselect
+				if( !collision && !ptr->selectionIsToggle && ptr->unselectIfLostFocus )
+					ptr->Deselect();
+			}
+
+			// Selection (or can be deselection for toggle mode)
+			if( ptr->isFocussed && m_mousePressed )
+			{
+				ptr->isSelected && ptr->selectionIsToggle ? ptr->Deselect() : ptr->Select();
+				m_mousePressed = false;
+			}
 
-					if( !collision && ptr->focusChangedCallback )
-						ptr->focusChangedCallback( interactable, false );
-					else if( collision && ptr->focusChangedCallback )
-						ptr->focusChangedCallback( interactable, true );
+			// Un-selection
+			if( m_mouseReleased && !ptr->selectionIsToggle )
+				ptr->Deselect();
+		}
 
-					// Lost highlight, then we also unselect
-					if( !collision && !ptr->selectionIsToggle && ptr->unselectIfLostFocus )
-						ptr->Deselect();
-				}
+		void InteractableSystem::Update( const float deltaTime )
+		{
+			const auto window = GetWorld().GetContext().window;
+			const auto mousePosition = window->mapPixelToCoords( sf::Mouse::getPosition( *window ) );
+
+			if( GetWorld().GetStorageMode() == World::StorageMode::Archetype )
+			{
+				m_collisions.clear();
 
-				// Selection (or can be deselection for toggle mode)
-				if( ptr->isFocussed && m_mousePressed )
+				GetWorld().ForEachChunk< Transform, Interactable, SFMLObject >(
+					[&]( const unsigned count, const Transform* transforms, const Interactable* interactables, const SFMLObject* sfmlObjs )
 				{
-					ptr->isSelected && ptr->selectionIsToggle ? ptr->Deselect() : ptr->Select();
-					m_mousePressed = false;
-				}
+					for( unsigned i = 0U; i < count; ++i )
+					{
+						const auto& replaced = interactables[i].m_replaceCollisionObject;
+						const auto& sfmlObj = replaced ? *replaced.Get() : sfmlObjs[i];
+						m_collisions.emplace_back( InteractableHandle( interactables[i].m_self ), CheckCollision( transforms[i], sfmlObj, mousePosition ) );
+					}
+				} );
 
-				// Un-selection
-				if( m_mouseReleased && !ptr->selectionIsToggle )
-					ptr->Deselect();
-			} );
+				for( auto& collision : m_collisions )
+					if( collision.first )
+						UpdateInteraction( collision.first, collision.second );
+			}
+			else
+			{
+				ForEachSystemComponent< Transform, Interactable, SFMLObject >(
+					[&]( const TransformHandle& transform, const InteractableHandle& interactable, const SFMLObjectHandle& sfmlObj )
+				{
+					UpdateInteraction( interactable, CheckCollision( *transform.Get(), *sfmlObj.Get(), mousePosition ) );
+				} );
+			}
 
 			m_mouseReleased = false;
 		}
@@ -3,6 +3,20 @@
 #include "System.h"
 #include "TransformComponent.h"
 
+namespace Reflex
+{
+	namespace Components
+	{
+		class Interactable;
+		class SFMLObject;
+	}
+
+	namespace Core
+	{
+		typedef Handle< class Reflex::Components::Interactable > InteractableHandle;
+	}
+}
+
 namespace Reflex
 {
 	namespace Systems
@@ -21,11 +35,19 @@ namespace Reflex
 			void OnSystemShutdown() final {}
 
 		protected:
-			bool CheckCollision( const TransformHandle& transform, const sf::FloatRect& localBounds, const sf::Vector2f& mousePosition ) const;
+			// Maps the mouse into the shape's local space (through the object's world affine and the shape's own transform) and tests it against the local bounds
+			bool CheckCollision( const Reflex::Components::Transform& transform, const sf::Transformable& shape, const sf::FloatRect& localBounds, const sf::Vector2f& mousePosition ) const;
+			bool CheckCollision( const Reflex::Components::Transform& transform, const Reflex::Components::SFMLObject& sfmlObj, const sf::Vector2f& mousePosition ) const;
+
+			// Focus & selection changes (and their callbacks) for the result of a collision test
+			void UpdateInteraction( const InteractableHandle& interactable, const bool collision );
 
 		protected:
 			bool m_mousePressed = false;
 			bool m_mouseReleased = false;
+
+			// Archetype storage tests collisions straight from the chunks and runs the callbacks afterwards, once no chunk pointers are live
+			std::vector< std::pair< InteractableHandle, bool > > m_collisions;
 		};
 	}
 }
\ No newline at end of file
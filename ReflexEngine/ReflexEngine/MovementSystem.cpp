@@ -16,20 +16,38 @@ namespace Reflex
 
 		void MovementSystem::Update( const float deltaTime )
 		{
-			ForEachSystemComponent< Transform >(
-				[&]( const TransformHandle& transform )
+			const auto updateTransform = [&]( Transform& transform )
 			{
-				if( transform->m_rotateDurationSec > 0.0f )
+				if( transform.m_rotateDurationSec > 0.0f )
 				{
-					const float step = std::min( transform->m_rotateDurationSec, deltaTime );
-					transform->m_rotateDurationSec = std::max( 0.0f, transform->m_rotateDurationSec - deltaTime );
+					const float step = std::min( transform.m_rotateDurationSec, deltaTime );
+					transform.m_rotateDurationSec = std::max( 0.0f, transform.m_rotateDurationSec - deltaTime );
 
-					transform->rotate( transform->m_rotateDegreesPerSec * step );
+					transform.rotate( transform.m_rotateDegreesPerSec * step );
 
-					if( transform->m_rotateDurationSec == 0.0f && transform->m_finishedRotationCallback )
-						transform->m_finishedRotationCallback( transform );
+					if( transform.m_rotateDurationSec == 0.0f && transform.m_finishedRotationCallback )
+						transform.m_finishedRotationCallback( TransformHandle( transform.m_self ) );
 				}
-			} );
+			};
+
+			// Rotation callbacks run while chunk pointers are live, so they must go through the world's CommandBuffer for structural changes
+			GetWorld().LockStructuralChanges();
+
+			// Archetype storage lets us walk the transform columns directly instead of going through handles
+			if( GetWorld().GetStorageMode() == World::StorageMode::Archetype )
+			{
+				GetWorld().ForEachChunk< Transform >( [&]( const unsigned count, Transform* transforms )
+				{
+					for( unsigned i = 0U; i < count; ++i )
+						updateTransform( transforms[i] );
+				} );
+			}
+			else
+			{
+				ForEach< Write< Transform > >( updateTransform );
+			}
+
+			GetWorld().UnlockStructuralChanges();
 		}
 	}
 }
\ No newline at end of file
@@ -9,31 +9,47 @@ namespace Reflex
 	{
 		Object::Object( World& world )
 			: m_world( world )
-			, m_cachedTransformType( Type( typeid( Reflex::Components::Transform ) ) )
+			, m_cachedTransformType( GetComponentTypeId< Reflex::Components::Transform >() )
 		{
 
 		}
 
-		void Object::Destroy()
+		Object::Object( Object&& other )
+			: Entity( other )
+			, m_world( other.m_world )
+			, m_destroyed( other.m_destroyed )
+			, m_components( std::move( other.m_components ) )
+			, m_cachedTransformType( other.m_cachedTransformType )
+			, m_signature( other.m_signature )
+			, m_archetypeLocation( other.m_archetypeLocation )
+			, m_systemEntries( std::move( other.m_systemEntries ) )
+		{
+
+		}
+
+		void Object::Destroy( const bool destroyChildren /*= false*/ )
 		{
 			if( !m_destroyed )
-			{
-				m_world.DestroyObject( m_self );
-				m_destroyed = true;
-			}
+				m_world.DestroyObject( m_self, destroyChildren );
+		}
+
+		bool Object::IsDestroyed() const
+		{
+			return m_destroyed;
 		}
 
 		void Object::RemoveAllComponents()
 		{
-			std::for_each( m_components.begin(), m_components.end(), [&]( const std::pair< Type, BaseHandle >& component )
+			std::for_each( m_components.begin(), m_components.end(), [&]( const std::pair< TypeId, BaseHandle >& component )
 			{
-				m_world.DestroyComponent( component.first, component.second );
+				m_world.DestroyComponent( *this, component.first, component.second );
 			} );
 
 			m_components.clear();
+			m_signature.reset();
 		}
 
-		BaseHandle Object::GetComponent( Type componentType ) const
+		BaseHandle Object::GetComponentByType( const TypeId componentType ) const
 		{
 			if( componentType == m_cachedTransformType )
 				return m_components[0].second;
@@ -68,23 +84,40 @@ namespace Reflex
 			return m_world;
 		}
 
-		void Object::RemoveComponentInternal(const Core::Type& componentType, const BaseHandle& handle)
+		const ComponentSignature& Object::GetSignature() const
 		{
-			const auto found = std::find_if(m_components.begin(), m_components.end(), [&](const std::pair< Type, BaseHandle >& component)
+			return m_signature;
+		}
+
+		void Object::RefreshSignature(const TypeId componentType)
+		{
+			// Objects can hold more than one component of a type, only clear the bit once the last one is gone
+			const auto found = std::find_if(m_components.begin(), m_components.end(), [componentType](const std::pair< TypeId, BaseHandle >& component)
+				{
+					return component.first == componentType;
+				});
+
+			m_signature.set(componentType, found != m_components.end());
+		}
+
+		void Object::RemoveComponentInternal(const TypeId componentType, const BaseHandle& handle)
+		{
+			const auto found = std::find_if(m_components.begin(), m_components.end(), [&](const std::pair< TypeId, BaseHandle >& component)
 				{
 					return component.second == handle;
 				});
 
 			if (found != m_components.end())
 			{
-				m_world.DestroyComponent(componentType, found->second);
+				m_world.DestroyComponent(*this, componentType, found->second);
 				m_components.erase(found);
+				RefreshSignature(componentType);
 			}
 		}
 
-		void Object::RemoveComponentInternal(const Core::Type& componentType)
+		void Object::RemoveComponentInternal(const TypeId componentType)
 		{
-			const auto found = std::find_if(m_components.begin(), m_components.end(), [&componentType](const std::pair< Type, BaseHandle >& componentHandle)
+			const auto found = std::find_if(m_components.begin(), m_components.end(), [componentType](const std::pair< TypeId, BaseHandle >& componentHandle)
 				{
 					if (!componentHandle.second.IsValid())
 						return false;
@@ -94,14 +127,15 @@ namespace Reflex
 
 			if (found != m_components.end())
 			{
-				m_world.DestroyComponent(componentType, found->second);
+				m_world.DestroyComponent(*this, componentType, found->second);
 				m_components.erase(found);
+				RefreshSignature(componentType);
 			}
 		}
 
-		void Object::RemoveComponentsInternal(const Core::Type& componentType)
+		void Object::RemoveComponentsInternal(const TypeId componentType)
 		{
-			m_components.erase(std::remove_if(m_components.begin(), m_components.end(), [&](const std::pair< Type, BaseHandle >& component)
+			m_components.erase(std::remove_if(m_components.begin(), m_components.end(), [&](const std::pair< TypeId, BaseHandle >& component)
 				{
 					if (!component.second.IsValid())
 						return false;
@@ -109,11 +143,13 @@ namespace Reflex
 					if (componentType != component.first)
 						return false;
 
-					m_world.DestroyComponent(componentType, component.second);
+					m_world.DestroyComponent(*this, componentType, component.second);
 
 					return true;
 				}
 			), m_components.end());
+
+			RefreshSignature(componentType);
 		}
 	}
 }
\ No newline at end of file
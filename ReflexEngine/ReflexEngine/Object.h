@@ -4,10 +4,13 @@
 #include "Component.h"
 #include "Entity.h"
 #include "TransformComponent.h"
+#include "ArchetypeStorage.h"
 
 
 namespace Reflex
 {
+	namespace Systems { class System; }
+
 	namespace Core
 	{
 		class World;
@@ -15,10 +18,16 @@ namespace Reflex
 		class Object : public Entity, private sf::NonCopyable
 		{
 		public:
+			friend class World;
+			friend class ArchetypeStorage;
+
 			Object( World& world );
+			Object( Object&& other );
 			virtual ~Object() { }
 
-			void Destroy();
+			// Destroying children takes the whole subtree below this object in the scene graph with it
+			void Destroy( const bool destroyChildren = false );
+			bool IsDestroyed() const;
 
 			// Creates and adds a new component of the template type and returns a handle to it
 			template< class T, typename... Args >
@@ -60,7 +69,7 @@ namespace Reflex
 			template< class T >
 			Handle< T > GetComponentAt( const unsigned index ) const;
 
-			BaseHandle GetComponent( Type componentType ) const;
+			BaseHandle GetComponentByType( const TypeId componentType ) const;
 			BaseHandle GetComponent( const unsigned index ) const;
 
 			template< class T >
@@ -74,6 +83,9 @@ namespace Reflex
 
 			World& GetWorld() const;
 
+			// Bit set for each component type this object currently has
+			const ComponentSignature& GetSignature() const;
+
 		protected:
 			Object() = delete;
 
@@ -86,38 +98,46 @@ namespace Reflex
 			//			return true;
 			//	return false;
 			//}
-			void RemoveComponentInternal(const Core::Type& componentType, const BaseHandle& handle);
-			void RemoveComponentInternal(const Core::Type& componentType);
-			void RemoveComponentsInternal(const Core::Type& componentType);
+			void RemoveComponentInternal(const TypeId componentType, const BaseHandle& handle);
+			void RemoveComponentInternal(const TypeId componentType);
+			void RemoveComponentsInternal(const TypeId componentType);
+			void RefreshSignature(const TypeId componentType);
 
 		protected:
 			World& m_world;
 			bool m_destroyed = false;
-			std::vector< std::pair< Type, BaseHandle > > m_components;
+			std::vector< std::pair< TypeId, BaseHandle > > m_components;
 
 		private:
-			Type m_cachedTransformType;
+			TypeId m_cachedTransformType;
+			ComponentSignature m_signature;
+
+			// Only used when the world is using archetype storage
+			ArchetypeLocation m_archetypeLocation;
+
+			// Every system entry this object is part of (system, entry id), lets removal skip searching the systems
+			std::vector< std::pair< Reflex::Systems::System*, unsigned > > m_systemEntries;
 		};
 
 		// Template definitions
 		template< class T >
 		void Object::RemoveComponents()
 		{
-			const auto componentType = Type( typeid( T ) );
+			const auto componentType = GetComponentTypeId< T >();
 			RemoveComponentsInternal(componentType);
 		}
 
 		template< class T >
 		void Object::RemoveComponent( Handle< T > handle )
 		{
-			const auto componentType = Type(typeid(T));
+			const auto componentType = GetComponentTypeId< T >();
 			RemoveComponentInternal(componentType, handle);
 		}
 
 		template< class T >
 		void Object::RemoveComponent()
 		{
-			const auto componentType = Type( typeid( T ) );
+			const auto componentType = GetComponentTypeId< T >();
 			RemoveComponentInternal(componentType);
 		}
 
@@ -130,7 +150,7 @@ namespace Reflex
 		template< class T >
 		Handle< T > Object::GetComponent( const unsigned index /*= 0U*/ ) const
 		{
-			const auto componentType = Type( typeid( T ) );
+			const auto componentType = GetComponentTypeId< T >();
 			unsigned count = index;
 
 			if( componentType == m_cachedTransformType )
@@ -160,7 +180,7 @@ namespace Reflex
 		template< class T >
 		std::vector< Handle< T > > Object::GetComponents() const
 		{
-			const auto componentType = Type( typeid( T ) );
+			const auto componentType = GetComponentTypeId< T >();
 
 			if( componentType == m_cachedTransformType )
 				return { m_components[0].second };
@@ -16,6 +16,12 @@
 #include <SFML/System/NonCopyable.hpp>
 //#include <Box2D.h>
 
+// SSE intrinsics where the target has them, anything using them keeps a plain fallback
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE__ )
+#define REFLEX_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "Utility.h"
 #include "Logging.h"
 #include "VectorSet.h"
@@ -14,14 +14,31 @@ namespace Reflex
 		{
 			RequiresComponent( Reflex::Components::SFMLObject );
 			RequiresComponent( Reflex::Components::Transform );
+
+			// Update only sorts on the render index
+			ReadsComponent( Reflex::Components::Transform );
 		}
 
 		void RenderSystem::Update( const float deltaTime )
 		{
-			std::sort( m_components.begin(), m_components.end(), []( const ComponentsSet& left, const ComponentsSet& right )
-			{
-				return Handle< Reflex::Components::Transform >( left[1] )->GetRenderIndex() < Handle< Reflex::Components::Transform >( right[1] )->GetRenderIndex();
-			} );
+			// Sorted as part of Render instead
+			if( GetWorld().GetStorageMode() == World::StorageMode::Archetype )
+				return;
+
+			// Resolve every transform once and sort on the cached render index instead of resolving two handles per comparison
+			ResolveSystemComponents( 1U, m_transforms );
+
+			m_sortKeys.resize( m_components.size() );
+			for( unsigned i = 0U; i < m_components.size(); ++i )
+				m_sortKeys[i] = std::make_pair( m_transforms[i] ? m_transforms[i]->GetRenderIndex() : 0U, i );
+
+			std::sort( m_sortKeys.begin(), m_sortKeys.end() );
+
+			m_order.resize( m_sortKeys.size() );
+			for( unsigned i = 0U; i < m_sortKeys.size(); ++i )
+				m_order[i] = m_sortKeys[i].second;
+
+			ReorderEntries( m_order );
 		}
 
 		void RenderSystem::Render( sf::RenderTarget& target, sf::RenderStates states ) const
@@ -29,38 +46,84 @@ namespace Reflex
 			PROFILE;
 			sf::RenderStates copied_states( states );
 
-			ForEachSystemComponent< Reflex::Components::SFMLObject, Reflex::Components::Transform >( 
-				[&target, &copied_states, &states]( SFMLObjectHandle object, TransformHandle transform )
+			// Gather straight from the chunks, no handles involved
+			if( GetWorld().GetStorageMode() == World::StorageMode::Archetype )
 			{
-				copied_states.transform = states.transform * transform->GetWorldTransform();
+				m_drawList.clear();
+
+				GetWorld().ForEachChunk< Reflex::Components::SFMLObject, Reflex::Components::Transform >(
+					[this]( const unsigned count, const Reflex::Components::SFMLObject* objects, const Reflex::Components::Transform* transforms )
+				{
+					for( unsigned i = 0U; i < count; ++i )
+						m_drawList.push_back( DrawEntry{ transforms[i].GetRenderIndex(), &objects[i], &transforms[i] } );
+				} );
 
-				switch( object->GetType() )
+				std::stable_sort( m_drawList.begin(), m_drawList.end(), []( const DrawEntry& left, const DrawEntry& right )
 				{
-				case Components::SFMLObjectType::Rectangle:
-					target.draw( object->GetRectangleShape(), copied_states );
-				break;
-				case Components::SFMLObjectType::Convex:
-					target.draw( object->GetConvexShape(), copied_states );
-				break;
-				case Components::SFMLObjectType::Circle:
-					target.draw( object->GetCircleShape(), copied_states );
-				break;
-				case Components::SFMLObjectType::Sprite:
-					target.draw( object->GetSprite(), copied_states );
-				break;
-				case Components::SFMLObjectType::Text:
-					target.draw( object->GetText(), copied_states );
-				break;
+					return left.renderIndex < right.renderIndex;
+				} );
+
+				for( auto& entry : m_drawList )
+				{
+					copied_states.transform = states.transform * entry.transform->GetWorldTransform();
+					Draw( target, *entry.object, copied_states );
 				}
+
+				return;
+			}
+
+			ForEach< Read< Reflex::Components::SFMLObject >, Read< Reflex::Components::Transform > >(
+				[&target, &copied_states, &states]( const Reflex::Components::SFMLObject& object, const Reflex::Components::Transform& transform )
+			{
+				copied_states.transform = states.transform * transform.GetWorldTransform();
+				Draw( target, object, copied_states );
 			} );
 		}
 
-		std::vector< System::ComponentsSet >::const_iterator RenderSystem::GetInsertionIndex( const ComponentsSet& newSet ) const
+		void RenderSystem::Draw( sf::RenderTarget& target, const Reflex::Components::SFMLObject& object, const sf::RenderStates& states )
 		{
-			return std::lower_bound( m_components.begin(), m_components.end(), newSet, []( const ComponentsSet& left, const ComponentsSet& right )
+			switch( object.GetType() )
 			{
-				return Handle< Reflex::Components::Transform >( left[1] )->GetRenderIndex() < Handle< Reflex::Components::Transform >( right[1] )->GetRenderIndex();
-			} );
+			case Components::SFMLObjectType::Rectangle:
+				target.draw( object.GetRectangleShape(), states );
+			break;
+			case Components::SFMLObjectType::Convex:
+				target.draw( object.GetConvexShape(), states );
+			break;
+			case Components::SFMLObjectType::Circle:
+				target.draw( object.GetCircleShape(), states );
+			break;
+			case Components::SFMLObjectType::Sprite:
+				target.draw( object.GetSprite(), states );
+			break;
+			case Components::SFMLObjectType::Text:
+				target.draw( object.GetText(), states );
+			break;
+			}
+		}
+
+		ComponentsTable::const_iterator RenderSystem::GetInsertionIndex( const ComponentsSet& newSet ) const
+		{
+			const auto renderIndex = Handle< Reflex::Components::Transform >( newSet[1] )->GetRenderIndex();
+
+			// Lower bound on the render index, where a tombstone counts as the next live entry after it (so the order stays sorted)
+			unsigned first = 0U;
+			unsigned last = m_components.size();
+
+			while( first < last )
+			{
+				unsigned live = first + ( last - first ) / 2U;
+
+				while( live < last && IsTombstone( m_components[live] ) )
+					++live;
+
+				if( live < last && Handle< Reflex::Components::Transform >( m_components[live][1] )->GetRenderIndex() < renderIndex )
+					first = live + 1U;
+				else
+					last = first + ( last - first ) / 2U;
+			}
+
+			return m_components.cbegin() + first;
 		}
 	}
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 namespace Reflex
 {
+	namespace Components { class Transform; class SFMLObject; }
+
 	namespace Systems
 	{
 		class RenderSystem : public System
@@ -17,7 +19,26 @@ namespace Reflex
 			void OnSystemStartup() final {}
 			void OnSystemShutdown() final { }
 
-			std::vector< ComponentsSet >::const_iterator GetInsertionIndex( const ComponentsSet& newSet ) const  final;
+			ComponentsTable::const_iterator GetInsertionIndex( const ComponentsSet& newSet ) const  final;
+			bool PreservesOrder() const final { return true; }
+
+		private:
+			static void Draw( sf::RenderTarget& target, const Reflex::Components::SFMLObject& object, const sf::RenderStates& states );
+
+			// Scratch buffers for sorting, kept around to avoid reallocating every frame
+			std::vector< Reflex::Components::Transform* > m_transforms;
+			std::vector< std::pair< unsigned, unsigned > > m_sortKeys;
+			std::vector< unsigned > m_order;
+
+			// Archetype storage draws straight from the chunks, sorted here each frame instead of reordering the entries
+			struct DrawEntry
+			{
+				unsigned renderIndex;
+				const Reflex::Components::SFMLObject* object;
+				const Reflex::Components::Transform* transform;
+			};
+
+			mutable std::vector< DrawEntry > m_drawList;
 		};
 	}
 }
\ No newline at end of file
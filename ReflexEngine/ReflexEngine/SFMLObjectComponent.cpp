@@ -49,7 +49,48 @@ namespace Reflex
 			: Component( other )
 			, m_type( other.m_type )
 		{
-			memcpy( &this->m_objectData, &other.m_objectData, sizeof( ObjectType ) );
+			// Construct whichever member of the union is active (the shapes / text own heap memory so can't just be memcpy'd)
+			switch( m_type )
+			{
+			case SFMLObjectType::Circle: new ( &m_objectData.circleShape ) sf::CircleShape( other.m_objectData.circleShape ); break;
+			case SFMLObjectType::Rectangle: new ( &m_objectData.rectShape ) sf::RectangleShape( other.m_objectData.rectShape ); break;
+			case SFMLObjectType::Convex: new ( &m_objectData.convexShape ) sf::ConvexShape( other.m_objectData.convexShape ); break;
+			case SFMLObjectType::Sprite: new ( &m_objectData.sprite ) sf::Sprite( other.m_objectData.sprite ); break;
+			case SFMLObjectType::Text: new ( &m_objectData.text ) sf::Text( other.m_objectData.text ); break;
+			}
+		}
+
+		SFMLObject::SFMLObject( SFMLObject&& other )
+			: Component( other )
+			, m_type( other.m_type )
+		{
+			switch( m_type )
+			{
+			case SFMLObjectType::Circle: new ( &m_objectData.circleShape ) sf::CircleShape( std::move( other.m_objectData.circleShape ) ); break;
+			case SFMLObjectType::Rectangle: new ( &m_objectData.rectShape ) sf::RectangleShape( std::move( other.m_objectData.rectShape ) ); break;
+			case SFMLObjectType::Convex: new ( &m_objectData.convexShape ) sf::ConvexShape( std::move( other.m_objectData.convexShape ) ); break;
+			case SFMLObjectType::Sprite: new ( &m_objectData.sprite ) sf::Sprite( std::move( other.m_objectData.sprite ) ); break;
+			case SFMLObjectType::Text: new ( &m_objectData.text ) sf::Text( std::move( other.m_objectData.text ) ); break;
+			}
+		}
+
+		SFMLObject::~SFMLObject()
+		{
+			DestroyObjectData();
+		}
+
+		void SFMLObject::DestroyObjectData()
+		{
+			switch( m_type )
+			{
+			case SFMLObjectType::Circle: m_objectData.circleShape.~CircleShape(); break;
+			case SFMLObjectType::Rectangle: m_objectData.rectShape.~RectangleShape(); break;
+			case SFMLObjectType::Convex: m_objectData.convexShape.~ConvexShape(); break;
+			case SFMLObjectType::Sprite: m_objectData.sprite.~Sprite(); break;
+			case SFMLObjectType::Text: m_objectData.text.~Text(); break;
+			}
+
+			m_type = SFMLObjectType::Invalid;
 		}
 
 		sf::CircleShape& SFMLObject::GetCircleShape()
@@ -36,7 +36,8 @@ namespace Reflex
 			SFMLObject( const sf::Sprite& spriteconst, const sf::Color& colour = sf::Color::White );
 			SFMLObject( const sf::Text& text, const sf::Color& colour = sf::Color::White );
 			SFMLObject( const SFMLObject& other );
-			~SFMLObject() { }
+			SFMLObject( SFMLObject&& other );
+			~SFMLObject();
 
 			// Get functions
 			sf::CircleShape& GetCircleShape();
@@ -57,6 +58,8 @@ namespace Reflex
 			const SFMLObjectType GetType() const;
 
 		private:
+			void DestroyObjectData();
+
 			union ObjectType
 			{
 				sf::CircleShape circleShape;			// 292 bytes
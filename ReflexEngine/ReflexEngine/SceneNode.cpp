@@ -1,6 +1,7 @@
 #include "SceneNode.h"
 #include "Object.h"
 #include "TransformComponent.h"
+#include "World.h"
 
 namespace Reflex
 {
@@ -11,7 +12,11 @@ namespace Reflex
 		SceneNode::SceneNode()
 			: m_owningObject( ObjectHandle::null )
 			, m_parent( ObjectHandle::null )
-			, m_children()
+			, m_firstChild( ObjectHandle::null )
+			, m_lastChild( ObjectHandle::null )
+			, m_prevSibling( ObjectHandle::null )
+			, m_nextSibling( ObjectHandle::null )
+			, m_childCount( 0U )
 			, m_renderIndex( 0U )
 			, m_layerIndex( 0U )
 		{
@@ -21,17 +26,71 @@ namespace Reflex
 		SceneNode::SceneNode( const SceneNode& other )
 			: m_owningObject( ObjectHandle::null )
 			, m_parent( ObjectHandle::null )
-			, m_children()
+			, m_firstChild( ObjectHandle::null )
+			, m_lastChild( ObjectHandle::null )
+			, m_prevSibling( ObjectHandle::null )
+			, m_nextSibling( ObjectHandle::null )
+			, m_childCount( 0U )
 			, m_renderIndex( other.m_renderIndex )
 			, m_layerIndex( other.m_layerIndex )
 		{
 
 		}
 
+		SceneNode::SceneNode( SceneNode&& other )
+			: sf::Transformable( other )
+			, m_owningObject( other.m_owningObject )
+			, m_parent( other.m_parent )
+			, m_firstChild( other.m_firstChild )
+			, m_lastChild( other.m_lastChild )
+			, m_prevSibling( other.m_prevSibling )
+			, m_nextSibling( other.m_nextSibling )
+			, m_childCount( other.m_childCount )
+			, m_worldAffine( other.m_worldAffine )
+			, m_worldTranslation( other.m_worldTranslation )
+			, m_worldScale( other.m_worldScale )
+			, m_worldRotation( other.m_worldRotation )
+			, m_worldTransformDirty( other.m_worldTransformDirty )
+			, m_hierarchy( other.m_hierarchy )
+			, m_hierarchySlot( other.m_hierarchySlot )
+			, m_spatialSyncQueued( other.m_spatialSyncQueued )
+			, m_renderIndex( other.m_renderIndex )
+			, m_layerIndex( other.m_layerIndex )
+		{
+			// Links are object handles, so the rest of the tree still finds us after the move
+			// The moved from node is about to be destroyed, make sure it doesn't detach us from our parent or orphan our children
+			other.m_owningObject = ObjectHandle::null;
+			other.m_parent = ObjectHandle::null;
+			other.m_firstChild = ObjectHandle::null;
+			other.m_lastChild = ObjectHandle::null;
+			other.m_childCount = 0U;
+			other.m_hierarchy = nullptr;
+		}
+
 		SceneNode::~SceneNode()
 		{
+			// Unlink ourselves directly, our owning object may already be on its way out
 			if( m_parent )
-				m_parent->GetTransform()->DetachChild( m_owningObject );
+			{
+				auto parent = m_parent->GetTransform();
+				if( parent->IsLinked( *this ) )
+					parent->Unlink( *this );
+			}
+
+			// Orphan any children that are still around, they are no longer under the hierarchy's root
+			for( ObjectHandle child = m_firstChild; child; )
+			{
+				auto transform = child->GetTransform();
+				child = transform->m_nextSibling;
+
+				if( transform->m_hierarchy )
+					transform->m_hierarchy->RemoveSubtree( *transform.Get() );
+
+				transform->m_parent = ObjectHandle::null;
+				transform->m_prevSibling = ObjectHandle::null;
+				transform->m_nextSibling = ObjectHandle::null;
+				transform->OnTransformChanged();
+			}
 		}
 
 		void SceneNode::AttachChild( const ObjectHandle& child )
@@ -42,86 +101,255 @@ namespace Reflex
 				transform->m_parent->GetTransform()->DetachChild( child );
 
 			transform->m_parent = m_owningObject;
+			transform->OnTransformChanged();
 			transform->SetZOrder( s_nextRenderIndex++ );
 			transform->SetLayer( m_layerIndex + 1 );
-			//m_children.insert( child );
-			m_children.push_back( child );
+
+			// Append to the end so children keep the order they were attached in
+			transform->m_prevSibling = m_lastChild;
+			transform->m_nextSibling = ObjectHandle::null;
+
+			if( m_lastChild )
+				m_lastChild->GetTransform()->m_nextSibling = child;
+			else
+				m_firstChild = child;
+
+			m_lastChild = child;
+			++m_childCount;
+
+			// Only the new child's subtree needs a slot (and it only gets one if we are under the root ourselves)
+			if( m_hierarchy )
+				m_hierarchy->AddSubtree( *transform.Get(), m_hierarchySlot );
 		}
 
 		ObjectHandle SceneNode::DetachChild( const ObjectHandle& node )
 		{
-			// Find and detach the node'
-			for( unsigned i = 0U; i < m_children.size(); ++i )
+			if( !node || !IsLinked( *node->GetTransform().Get() ) )
 			{
-				if( node == m_children[i] )
-				{
-					if( m_children[i] )
-						m_children[i]->GetTransform()->m_parent = ObjectHandle::null;
-
-					m_children.erase( m_children.begin() + i );
-					return node;
-				}
+				LOG_CRIT( "Node not found" );
+				return ObjectHandle::null;
 			}
 
-			LOG_CRIT( "Node not found" );
-			return ObjectHandle::null;
+			auto transform = node->GetTransform();
+			Unlink( *transform.Get() );
+			transform->OnTransformChanged();
+			return node;
 		}
 
-		sf::Transform SceneNode::GetWorldTransform() const
+		bool SceneNode::IsLinked( const SceneNode& child ) const
 		{
-			TODO( "Cache the world transform" );
-			sf::Transform worldTransform;
+			// Only our first child has no previous sibling
+			return child.m_parent == m_owningObject && ( child.m_prevSibling || m_firstChild == child.m_owningObject );
+		}
 
-			for( ObjectHandle node = m_owningObject; node != ObjectHandle::null; node = node->GetTransform()->m_parent )
-				worldTransform = node->GetTransform()->getTransform() * worldTransform;
+		void SceneNode::Unlink( SceneNode& child )
+		{
+			if( child.m_prevSibling )
+				child.m_prevSibling->GetTransform()->m_nextSibling = child.m_nextSibling;
+			else
+				m_firstChild = child.m_nextSibling;
+
+			if( child.m_nextSibling )
+				child.m_nextSibling->GetTransform()->m_prevSibling = child.m_prevSibling;
+			else
+				m_lastChild = child.m_prevSibling;
+
+			child.m_parent = ObjectHandle::null;
+			child.m_prevSibling = ObjectHandle::null;
+			child.m_nextSibling = ObjectHandle::null;
+			--m_childCount;
+
+			if( child.m_hierarchy )
+				child.m_hierarchy->RemoveSubtree( child );
+		}
 
-			return worldTransform;
+		void SceneNode::setPosition( float x, float y )
+		{
+			sf::Transformable::setPosition( x, y );
+			OnTransformChanged();
+		}
+
+		void SceneNode::setPosition( const sf::Vector2f& position )
+		{
+			sf::Transformable::setPosition( position );
+			OnTransformChanged();
+		}
+
+		void SceneNode::setRotation( float angle )
+		{
+			sf::Transformable::setRotation( angle );
+			OnTransformChanged();
+		}
+
+		void SceneNode::setScale( float factorX, float factorY )
+		{
+			sf::Transformable::setScale( factorX, factorY );
+			OnTransformChanged();
+		}
+
+		void SceneNode::setScale( const sf::Vector2f& factors )
+		{
+			sf::Transformable::setScale( factors );
+			OnTransformChanged();
+		}
+
+		void SceneNode::setOrigin( float x, float y )
+		{
+			sf::Transformable::setOrigin( x, y );
+			OnTransformChanged();
+		}
+
+		void SceneNode::setOrigin( const sf::Vector2f& origin )
+		{
+			sf::Transformable::setOrigin( origin );
+			OnTransformChanged();
+		}
+
+		void SceneNode::move( float offsetX, float offsetY )
+		{
+			sf::Transformable::move( offsetX, offsetY );
+			OnTransformChanged();
+		}
+
+		void SceneNode::move( const sf::Vector2f& offset )
+		{
+			sf::Transformable::move( offset );
+			OnTransformChanged();
+		}
+
+		void SceneNode::rotate( float angle )
+		{
+			sf::Transformable::rotate( angle );
+			OnTransformChanged();
+		}
+
+		void SceneNode::scale( float factorX, float factorY )
+		{
+			sf::Transformable::scale( factorX, factorY );
+			OnTransformChanged();
+		}
+
+		void SceneNode::scale( const sf::Vector2f& factor )
+		{
+			sf::Transformable::scale( factor );
+			OnTransformChanged();
+		}
+
+		const Reflex::Affine2D& SceneNode::GetWorldAffine() const
+		{
+			UpdateWorldTransform();
+			return m_worldAffine;
+		}
+
+		sf::Transform SceneNode::GetWorldTransform() const
+		{
+			return GetWorldAffine().ToTransform();
 		}
 
 		sf::Vector2f SceneNode::GetWorldPosition() const
 		{
-			return GetWorldTransform() * sf::Vector2f();
+			return GetWorldAffine().GetTranslation();
 		}
 
 		sf::Vector2f SceneNode::GetWorldTranslation() const
 		{
-			sf::Vector2f worldTranslation;
+			UpdateWorldTransform();
+			return m_worldTranslation;
+		}
+
+		float SceneNode::GetWorldRotation() const
+		{
+			UpdateWorldTransform();
+			return m_worldRotation;
+		}
+
+		sf::Vector2f SceneNode::GetWorldScale() const
+		{
+			UpdateWorldTransform();
+			return m_worldScale;
+		}
+
+		bool SceneNode::IsWorldTransformDirty() const
+		{
+			return m_worldTransformDirty;
+		}
+
+		void SceneNode::OnTransformChanged()
+		{
+			if( !m_owningObject )
+			{
+				MarkWorldTransformDirty();
+				return;
+			}
+
+			auto& world = m_owningObject->GetWorld();
+			auto& hierarchy = world.GetTransformHierarchy();
+			hierarchy.OnTransformsChanged();
 
-			for( ObjectHandle node = m_owningObject; node != ObjectHandle::null; node = node->GetTransform()->m_parent )
+			// Our descendants could be being written by another thread, so only mark ourselves (the hierarchy marks them once the parallel work is done)
+			// Already being dirty means we are either queued already or our descendants are dirty too
+			if( world.StructuralChangesLocked() )
+			{
+				if( !m_worldTransformDirty )
+				{
+					m_worldTransformDirty = true;
+					hierarchy.QueueParallelChange( m_owningObject );
+				}
+			}
+			else
 			{
-				worldTranslation.x += node->GetTransform()->getPosition().x;
-				worldTranslation.y += node->GetTransform()->getPosition().y;
+				MarkWorldTransformDirty();
 			}
 
-			return worldTranslation;
+			// Only this node is queued, the spatial sync takes care of its descendants
+			if( !m_spatialSyncQueued )
+			{
+				m_spatialSyncQueued = true;
+				world.GetTileMap().QueueSync( m_owningObject );
+			}
 		}
 
-		float SceneNode::GetWorldRotation() const
+		void SceneNode::MarkWorldTransformDirty()
 		{
-			float worldRotation = 0.0f;
+			// Already dirty means every descendant is too
+			if( m_worldTransformDirty )
+				return;
+
+			m_worldTransformDirty = true;
 
-			for( ObjectHandle node = m_owningObject; node != ObjectHandle::null; node = node->GetTransform()->m_parent )
-				worldRotation += node->GetTransform()->getRotation();
+			if( m_hierarchy )
+				m_hierarchy->QueueDirty( *this );
 
-			return worldRotation;
+			ForEachChild( []( const ObjectHandle& child ) { child->GetTransform()->MarkWorldTransformDirty(); } );
 		}
 
-		sf::Vector2f SceneNode::GetWorldScale() const
+		void SceneNode::UpdateWorldTransform() const
 		{
-			sf::Vector2f worldScale( 1.0f, 1.0f );
+			if( !m_worldTransformDirty )
+				return;
 
-			for( ObjectHandle node = m_owningObject; node != ObjectHandle::null; node = node->GetTransform()->m_parent )
+			m_worldAffine = Reflex::Affine2D::FromTransform( getTransform() );
+			m_worldTranslation = getPosition();
+			m_worldRotation = getRotation();
+			m_worldScale = getScale();
+
+			// Only one level up, the parent's own values come from its cache
+			if( m_parent )
 			{
-				worldScale.x *= node->GetTransform()->getScale().x;
-				worldScale.y *= node->GetTransform()->getScale().y;
+				const auto parent = m_parent->GetTransform();
+				m_worldAffine = parent->GetWorldAffine() * m_worldAffine;
+				m_worldTranslation += parent->m_worldTranslation;
+				m_worldRotation += parent->m_worldRotation;
+				m_worldScale.x *= parent->m_worldScale.x;
+				m_worldScale.y *= parent->m_worldScale.y;
 			}
 
-			return worldScale;
+			m_worldTransformDirty = false;
 		}
 
 		unsigned SceneNode::GetChildrenCount() const
 		{
-			return m_children.size();
+			return m_childCount;
 		}
 
 		ObjectHandle SceneNode::GetChild( const unsigned index ) const
@@ -132,7 +360,16 @@ namespace Reflex
 				return ObjectHandle::null;
 			}
 
-			return m_children[index];
+			auto child = m_firstChild;
+			for( unsigned i = 0U; i < index; ++i )
+				child = child->GetTransform()->m_nextSibling;
+
+			return child;
+		}
+
+		ObjectHandle SceneNode::GetNextSibling( const ObjectHandle& child )
+		{
+			return child->GetTransform()->m_nextSibling;
 		}
 
 		ObjectHandle SceneNode::GetParent() const
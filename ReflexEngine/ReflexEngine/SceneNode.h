@@ -2,23 +2,48 @@
 
 #include "Precompiled.h"
 #include "HandleFwd.hpp"
+#include "Affine2D.h"
 #include "GRIDComponent.h"
 
 namespace Reflex
 {
 	namespace Core
 	{
+		class TransformHierarchy;
+
 		class SceneNode : public sf::Transformable
 		{
 		public:
 			friend class Reflex::Components::Grid;
+			friend class TransformHierarchy;
+			friend class TileMap;
 			SceneNode();
 			SceneNode( const SceneNode& other );
+			SceneNode( SceneNode&& other );
 			~SceneNode();
 
+			// Attaching, detaching and reparenting are constant time, children are kept as a linked list through their sibling handles
 			void AttachChild( const ObjectHandle& child );
 			ObjectHandle DetachChild( const ObjectHandle& node );
 
+			// Local transform changes mark this node and its descendants dirty instead of going through sf::Transformable directly
+			// Calls made through an sf::Transformable reference bypass these, so avoid changing a node that way
+			void setPosition( float x, float y );
+			void setPosition( const sf::Vector2f& position );
+			void setRotation( float angle );
+			void setScale( float factorX, float factorY );
+			void setScale( const sf::Vector2f& factors );
+			void setOrigin( float x, float y );
+			void setOrigin( const sf::Vector2f& origin );
+			void move( float offsetX, float offsetY );
+			void move( const sf::Vector2f& offset );
+			void rotate( float angle );
+			void scale( float factorX, float factorY );
+			void scale( const sf::Vector2f& factor );
+
+			// World values are cached and only recalculated (from the parent's cached values) after the node has been marked dirty
+			// Recalculation happens lazily on read, so reading a dirty node from several threads at once isn't safe
+			const Reflex::Affine2D& GetWorldAffine() const;
 			sf::Transform GetWorldTransform() const;
 			sf::Vector2f GetWorldPosition() const; 
 
@@ -26,13 +51,22 @@ namespace Reflex
 			float GetWorldRotation() const;
 			sf::Vector2f GetWorldScale() const;
 
+			bool IsWorldTransformDirty() const;
+
+			// The next sibling is fetched before calling function, so it is free to detach the child it is given
 			template< typename Func >
 			void ForEachChild( Func function )
 			{
-				std::for_each( m_children.begin(), m_children.end(), function );
+				for( ObjectHandle child = m_firstChild; child != ObjectHandle::null; )
+				{
+					const auto next = GetNextSibling( child );
+					function( child );
+					child = next;
+				}
 			}
 
 			unsigned GetChildrenCount() const;
+			// Walks the children, so linear in index
 			ObjectHandle GetChild( const unsigned index ) const;
 			ObjectHandle GetParent() const;
 			void SetZOrder( const unsigned renderIndex );
@@ -40,11 +74,40 @@ namespace Reflex
 			void SetLayer( const unsigned layerIndex );
 			unsigned GetRenderIndex() const;
 
+		protected:
+			static ObjectHandle GetNextSibling( const ObjectHandle& child );
+			// Whether child is actually linked into our list, not just pointing at us as its parent
+			bool IsLinked( const SceneNode& child ) const;
+			void Unlink( SceneNode& child );
+
+			// Marks the world transform dirty and queues the object for the TileMap's next Sync
+			// Safe to call from parallel systems for nodes that thread owns, as only this node is touched while the world is locked (see TransformHierarchy::QueueParallelChange)
+			void OnTransformChanged();
+			void MarkWorldTransformDirty();
+			void UpdateWorldTransform() const;
+
 		protected:
 			ObjectHandle m_owningObject;
 			ObjectHandle m_parent;
-		//	Reflex::VectorSet< ObjectHandle > m_children;
-			std::vector< ObjectHandle > m_children;
+			ObjectHandle m_firstChild;
+			ObjectHandle m_lastChild;
+			ObjectHandle m_prevSibling;
+			ObjectHandle m_nextSibling;
+			unsigned m_childCount = 0U;
+
+			// Cached world values, a dirty node's descendants are always dirty as well (outside of parallel sections, see OnTransformChanged)
+			mutable Reflex::Affine2D m_worldAffine;
+			mutable sf::Vector2f m_worldTranslation;
+			mutable sf::Vector2f m_worldScale = sf::Vector2f( 1.0f, 1.0f );
+			mutable float m_worldRotation = 0.0f;
+			mutable bool m_worldTransformDirty = true;
+
+			// Slot in the world's TransformHierarchy, only set while we are under its root (the slot is meaningless while m_hierarchy is null)
+			TransformHierarchy* m_hierarchy = nullptr;
+			unsigned m_hierarchySlot = 0U;
+
+			// Waiting in the TileMap's sync queue
+			bool m_spatialSyncQueued = false;
 			unsigned m_renderIndex = 0U;
 			unsigned m_layerIndex = 0U;
 
@@ -0,0 +1,183 @@
+#include "System.h"
+#include "Object.h"
+#include "World.h"
+
+namespace Reflex
+{
+	namespace Systems
+	{
+		unsigned System::AddEntry( const std::vector< BaseHandle >& handles )
+		{
+			assert( handles.size() == m_requiredComponentTypes.size() );
+			m_components.SetStride( ( unsigned )m_requiredComponentTypes.size() );
+
+			// Tombstones are left for the per frame CompactEntries, GetInsertionIndex has to skip over them
+			const ComponentsSet set( const_cast< BaseHandle* >( handles.data() ), ( unsigned )handles.size() );
+			const unsigned slot = ( unsigned )( GetInsertionIndex( set ) - m_components.cbegin() );
+
+			unsigned entryId = ( unsigned )m_entrySlots.size();
+
+			if( !m_freeEntryIds.empty() )
+			{
+				entryId = m_freeEntryIds.back();
+				m_freeEntryIds.pop_back();
+			}
+			else
+			{
+				m_entrySlots.push_back( InvalidEntry );
+			}
+
+			// Landing on a tombstone can reuse it without shifting anything
+			if( slot < m_components.size() && m_entryIds[slot] == InvalidEntry )
+			{
+				m_components.Set( slot, set );
+				m_entryIds[slot] = entryId;
+				m_entrySlots[entryId] = slot;
+				--m_numTombstones;
+				return entryId;
+			}
+
+			m_components.Insert( slot, handles.data() );
+			m_entryIds.insert( m_entryIds.begin() + slot, entryId );
+
+			// Entries after the insertion point have shifted along by one
+			for( unsigned i = slot; i < m_entryIds.size(); ++i )
+				if( m_entryIds[i] != InvalidEntry )
+					m_entrySlots[m_entryIds[i]] = i;
+
+			return entryId;
+		}
+
+		void System::RemoveEntry( const unsigned entryId )
+		{
+			const unsigned slot = m_entrySlots[entryId];
+			assert( slot != InvalidEntry );
+
+			if( PreservesOrder() )
+			{
+				const auto set = m_components[slot];
+				std::fill( set.begin(), set.end(), BaseHandle::null );
+				m_entryIds[slot] = InvalidEntry;
+				++m_numTombstones;
+			}
+			else
+			{
+				// Move the last entry into the gap
+				const unsigned last = ( unsigned )m_components.size() - 1U;
+
+				if( slot != last )
+				{
+					m_components.Set( slot, m_components[last] );
+					m_entryIds[slot] = m_entryIds[last];
+					m_entrySlots[m_entryIds[slot]] = slot;
+				}
+
+				m_components.PopBack();
+				m_entryIds.pop_back();
+			}
+
+			m_entrySlots[entryId] = InvalidEntry;
+			m_freeEntryIds.push_back( entryId );
+		}
+
+		ComponentsSet System::GetEntry( const unsigned entryId ) const
+		{
+			return m_components[m_entrySlots[entryId]];
+		}
+
+		void System::CompactEntries()
+		{
+			if( !m_numTombstones )
+				return;
+
+			unsigned write = 0U;
+
+			for( unsigned read = 0U; read < m_components.size(); ++read )
+			{
+				if( m_entryIds[read] == InvalidEntry )
+					continue;
+
+				if( read != write )
+				{
+					m_components.Set( write, m_components[read] );
+					m_entryIds[write] = m_entryIds[read];
+				}
+
+				m_entrySlots[m_entryIds[write]] = write;
+				++write;
+			}
+
+			m_components.Resize( write );
+			m_entryIds.resize( write );
+			m_numTombstones = 0U;
+		}
+
+		void System::ClearEntries()
+		{
+			m_components.Clear();
+			m_entryIds.clear();
+			m_entrySlots.clear();
+			m_freeEntryIds.clear();
+			m_numTombstones = 0U;
+		}
+
+		bool System::ConflictsWith( const System& other ) const
+		{
+			if( !m_declaresAccess || !other.m_declaresAccess )
+				return true;
+
+			return ( m_writeSignature & ( other.m_readSignature | other.m_writeSignature ) ).any() || ( other.m_writeSignature & m_readSignature ).any();
+		}
+
+		unsigned System::GetNumThreads() const
+		{
+			return m_world.GetContext().threadPool ? m_world.GetContext().threadPool->GetNumThreads() : 1U;
+		}
+
+		ThreadPool* System::GetThreadPool() const
+		{
+			return m_world.GetContext().threadPool;
+		}
+
+		void System::LockStructuralChanges( const bool lock ) const
+		{
+			lock ? m_world.LockStructuralChanges() : m_world.UnlockStructuralChanges();
+		}
+
+		const Object* System::GetOwner( void* component )
+		{
+			return component ? ( ( Reflex::Components::Component* )component )->GetObject().Get() : nullptr;
+		}
+
+		bool System::HasComponentType( const Object& owner, const TypeId type )
+		{
+			return owner.GetSignature().test( type );
+		}
+
+		void* System::GetComponentByType( const Object& owner, const TypeId type )
+		{
+			return BaseHandle::s_handleManager->Get( owner.GetComponentByType( type ) );
+		}
+
+		void System::ReorderEntries( const std::vector< unsigned >& order )
+		{
+			assert( order.size() == m_components.size() );
+
+			m_reorderedComponents.SetStride( m_components.GetStride() );
+			m_reorderedComponents.Resize( ( unsigned )order.size() );
+			m_reorderedIds.resize( order.size() );
+
+			for( unsigned i = 0U; i < order.size(); ++i )
+			{
+				m_reorderedComponents.Set( i, m_components[order[i]] );
+				m_reorderedIds[i] = m_entryIds[order[i]];
+
+				if( m_reorderedIds[i] != InvalidEntry )
+					m_entrySlots[m_reorderedIds[i]] = i;
+			}
+
+			m_components.Swap( m_reorderedComponents );
+			m_entryIds.swap( m_reorderedIds );
+		}
+	}
+}
\ No newline at end of file
@@ -2,6 +2,12 @@
 
 #include "Precompiled.h"
 #include "Handle.h"
+#include "Component.h"
+#include "ComponentsTable.h"
+#include "ThreadPool.h"
+
+#include <utility>
+#include <tuple>
 
 namespace Reflex
 {
@@ -12,7 +18,67 @@ namespace Reflex
 		using namespace Reflex::Core;
 
 #define RequiresComponent( T ) GetWorld().ForwardRegisterComponent< T >(); \
-		m_requiredComponentTypes.push_back( Type( typeid( T ) ) );
+		m_requiredComponentTypes.push_back( GetComponentTypeId< T >() ); \
+		m_requiredSignature.set( GetComponentTypeId< T >() );
+
+		// Declaring access lets World run this system's Update alongside others that don't conflict with it
+		// A system that declares access must only touch the components it declared (plus its own members) during Update
+		// Systems that declare nothing (EG. those which create objects or call out to user callbacks) always run on their own
+#define ReadsComponent( T ) m_readSignature.set( GetComponentTypeId< T >() ); \
+		m_declaresAccess = true;
+
+#define WritesComponent( T ) m_writeSignature.set( GetComponentTypeId< T >() ); \
+		m_declaresAccess = true;
+
+		// Access tags for System::ForEach, a plain T is the same as Write< T >
+		template< class T > struct Read { };		// Passed as const T&
+		template< class T > struct Write { };		// Passed as T&
+		template< class T > struct Optional { };	// Passed as T* (nullptr if the object has none), doesn't need to be a required component
+		template< class T > struct Exclude { };		// Objects with a component of this type are skipped, nothing is passed
+
+		template< class Tag >
+		struct QueryTraits
+		{
+			typedef Tag Type;
+			enum { Required = true, Excluded = false };
+			static std::tuple< Tag& > Arg( void* resolved ) { return std::tuple< Tag& >( *( Tag* )resolved ); }
+		};
+
+		template< class T >
+		struct QueryTraits< Write< T > > : QueryTraits< T > { };
+
+		template< class T >
+		struct QueryTraits< Read< T > >
+		{
+			typedef T Type;
+			enum { Required = true, Excluded = false };
+			static std::tuple< const T& > Arg( void* resolved ) { return std::tuple< const T& >( *( const T* )resolved ); }
+		};
+
+		template< class T >
+		struct QueryTraits< Optional< T > >
+		{
+			typedef T Type;
+			enum { Required = false, Excluded = false };
+			static std::tuple< T* > Arg( void* resolved ) { return std::tuple< T* >( ( T* )resolved ); }
+		};
+
+		template< class T >
+		struct QueryTraits< Exclude< T > >
+		{
+			typedef T Type;
+			enum { Required = false, Excluded = true };
+			static std::tuple<> Arg( void* resolved ) { return std::tuple<>(); }
+		};
+
+		// Passed to ParallelForEach callbacks, thread can index per thread scratch (sized by System::GetNumThreads)
+		struct ParallelContext
+		{
+			unsigned chunk;
+			unsigned begin;
+			unsigned end;
+			unsigned thread;
+		};
 
 		class System : private sf::NonCopyable, public sf::Drawable
 		{
@@ -23,10 +89,12 @@ namespace Reflex
 			System( World& world ) : m_world( world ) { }
 			virtual ~System() { }
 
-			const std::vector< Type >& GetRequiredComponentTypes() const { return m_requiredComponentTypes; }
-			World& GetWorld() { return m_world; }
+			const std::vector< TypeId >& GetRequiredComponentTypes() const { return m_requiredComponentTypes; }
+			const ComponentSignature& GetRequiredSignature() const { return m_requiredSignature; }
 
-			typedef std::vector< Reflex::Core::BaseHandle > ComponentsSet;
+			// Whether the two systems can't be updated at the same time
+			bool ConflictsWith( const System& other ) const;
+			World& GetWorld() { return m_world; }
 
 		protected:
 			virtual void RegisterComponents() = 0;
@@ -37,48 +105,220 @@ namespace Reflex
 			virtual void OnSystemStartup() { }
 			virtual void OnSystemShutdown() { }
 			virtual void OnComponentAdded() { }
-			virtual std::vector< ComponentsSet >::const_iterator GetInsertionIndex( const ComponentsSet& newSet ) const { return m_components.end(); }
+			virtual ComponentsTable::const_iterator GetInsertionIndex( const ComponentsSet& newSet ) const { return m_components.end(); }
+
+			// Systems which rely on the order of m_components (EG. sorted by GetInsertionIndex) should return true
+			// Removal then leaves a tombstone (a set of null handles) which is compacted out once per frame, instead of moving the last entry into the gap
+			virtual bool PreservesOrder() const { return false; }
+
+			// Reorders the entries so that new slot i holds the entry previously at slot order[i], keeps entry ids in sync
+			void ReorderEntries( const std::vector< unsigned >& order );
+
+			static bool IsTombstone( const ComponentsSet& set ) { return set.front().m_index == BaseHandle::null.m_index; }
 
 			template< typename T >
-			Handle< T > GetSystemComponent( const std::vector< Reflex::Core::BaseHandle >& set ) const
+			Handle< T > GetSystemComponent( const ComponentsSet& set ) const
 			{
-				const auto type = Type( typeid( T ) );
+				const auto type = GetComponentTypeId< T >();
 				for( unsigned i = 0U; i < m_requiredComponentTypes.size(); ++i )
 					if( m_requiredComponentTypes[i] == type )
 						return Handle< T >( set[i] );
 				return Handle< T >();
 			}
 
-			template< typename T, typename Func >
+			// Calls f with a handle to each of the first sizeof...( Ts ) components of every set (Ts must match the order they were required in)
+			template< typename... Ts, typename Func >
 			void ForEachSystemComponent( const Func& f ) const
 			{
-				for( auto& comp : m_components )
-					f( Handle< T >( comp[0] ) );
+				ForEachSystemComponentImpl< Ts... >( f, std::index_sequence_for< Ts... >() );
 			}
 
-			template< typename A, typename B, typename Func >
-			void ForEachSystemComponent( const Func& f ) const
+			// Calls f with references to the requested components of every set, resolved a block at a time up front
+			// Types can be in any order and wrapped in Read / Write / Optional / Exclude, EG.
+			// ForEach< Read< Transform >, Write< Velocity >, Exclude< Frozen > >( []( const Transform& t, Velocity& v ) { ... } );
+			// Sets with an invalid required component are skipped. Adding or removing objects / components inside f can leave the rest of the block dangling
+			template< typename... Tags, typename Func >
+			void ForEach( const Func& f ) const
 			{
-				for( auto& comp : m_components )
-					f( Handle< A >( comp[0] ), Handle< B >( comp[1] ) );
+				ForEachImpl< Tags... >( f, 0U, m_components.size(), std::index_sequence_for< Tags... >() );
 			}
 
-			template< typename A, typename B, typename C, typename Func >
-			void ForEachSystemComponent( const Func& f ) const
+			// Same as ForEach but the sets are split into chunks of grainSize which are spread over the world's thread pool
+			// Called as f( const ParallelContext& context, components... ), f must only touch the components passed in plus per thread / per chunk state
+			// Writing a Transform passed in is fine, while locked it only marks that node and queues it per thread (descendants are marked once the batch is done)
+			// Reading world transforms of other objects isn't, as they may be resolved lazily by another thread at the same time
+			// The world is locked while this runs, create or destroy objects / components through GetWorld().GetCommandBuffer() instead
+			template< typename... Tags, typename Func >
+			void ParallelForEach( const Func& f, const unsigned grainSize = DefaultGrainSize ) const
 			{
-				for( auto& comp : m_components )
-					f( Handle< A >( comp[0] ), Handle< B >( comp[1] ), Handle< C >( comp[2] ) );
+				const unsigned grain = std::max( 1U, grainSize );
+
+				const auto runChunk = [&]( const unsigned begin, const unsigned end )
+				{
+					const ParallelContext context = { begin / grain, begin, end, ThreadPool::GetThreadIndex() };
+
+					ForEachImpl< Tags... >( [&]( auto&&... components )
+					{
+						f( context, std::forward< decltype( components ) >( components )... );
+					}, begin, end, std::index_sequence_for< Tags... >() );
+				};
+
+				LockStructuralChanges( true );
+
+				if( auto* threadPool = GetThreadPool() )
+					threadPool->ParallelFor( m_components.size(), grain, runChunk );
+				else
+					for( unsigned begin = 0U; begin < m_components.size(); begin += grain )
+						runChunk( begin, std::min( m_components.size(), begin + grain ) );
+
+				LockStructuralChanges( false );
+			}
+
+			// Upper bound (exclusive) of ParallelContext::thread
+			unsigned GetNumThreads() const;
+
+			// Resolves the handle at column of every set in one pass, out[i] is nullptr if that handle is invalid
+			template< typename T >
+			void ResolveSystemComponents( const unsigned column, std::vector< T* >& out ) const
+			{
+				out.resize( m_components.size() );
+				BaseHandle::s_handleManager->ResolveBatch( m_components.Data() + column, m_components.size(), out.data(), m_components.GetStride() );
 			}
 
+			enum
+			{
+				ResolveBlockSize = 64,
+				DefaultGrainSize = ResolveBlockSize * 16,
+			};
+
 		private:
 			void draw( sf::RenderTarget& target, sf::RenderStates states ) const final { Render( target, states ); }
 
+			template< typename... Ts, typename Func, size_t... Is >
+			void ForEachSystemComponentImpl( const Func& f, std::index_sequence< Is... > ) const
+			{
+				for( auto& comp : m_components )
+					if( !IsTombstone( comp ) )
+						f( Handle< Ts >( comp[Is] )... );
+			}
+
+			// Object lookups for ForEach, defined out of line as Object can't be included here
+			static const Object* GetOwner( void* component );
+			static bool HasComponentType( const Object& owner, const TypeId type );
+			static void* GetComponentByType( const Object& owner, const TypeId type );
+
+			// Column of the first required component of type, or -1 if the system doesn't require it
+			int FindColumn( const TypeId type ) const
+			{
+				for( unsigned i = 0U; i < m_requiredComponentTypes.size(); ++i )
+					if( m_requiredComponentTypes[i] == type )
+						return ( int )i;
+				return -1;
+			}
+
+			// Helpers for ParallelForEach, defined out of line as World can't be included here
+			ThreadPool* GetThreadPool() const;
+			void LockStructuralChanges( const bool lock ) const;
+
+			template< typename... Tags, typename Func, size_t... Is >
+			void ForEachImpl( const Func& f, const unsigned first, const unsigned last, std::index_sequence< Is... > ) const
+			{
+				const unsigned numTags = sizeof...( Tags );
+				const unsigned stride = m_components.GetStride();
+				const TypeId types[] = { GetComponentTypeId< typename QueryTraits< Tags >::Type >()... };
+				const bool required[] = { QueryTraits< Tags >::Required... };
+				const bool excluded[] = { QueryTraits< Tags >::Excluded... };
+				int columns[numTags];
+
+				// Optional components the system doesn't require and all excluded ones have to be looked up through the owning object
+				bool needsOwner = false;
+
+				for( unsigned k = 0U; k < numTags; ++k )
+				{
+					columns[k] = excluded[k] ? -1 : FindColumn( types[k] );
+					assert( columns[k] != -1 || !required[k] );
+					needsOwner = needsOwner || columns[k] == -1;
+				}
+
+				// The last row holds the first component of each set, used to find the owner
+				void* resolved[numTags + 1][ResolveBlockSize] = {};
+
+				for( unsigned begin = first; begin < last; begin += ResolveBlockSize )
+				{
+					const unsigned count = std::min( last - begin, ( unsigned )ResolveBlockSize );
+					const BaseHandle* block = m_components.Data() + begin * stride;
+
+					for( unsigned k = 0U; k < numTags; ++k )
+						if( columns[k] != -1 )
+							BaseHandle::s_handleManager->ResolveBatch( block + columns[k], count, resolved[k], stride );
+
+					if( needsOwner )
+						BaseHandle::s_handleManager->ResolveBatch( block, count, resolved[numTags], stride );
+
+					for( unsigned i = 0U; i < count; ++i )
+					{
+						bool valid = true;
+
+						for( unsigned k = 0U; k < numTags; ++k )
+							valid = valid && ( columns[k] == -1 || resolved[k][i] || !required[k] );
+
+						if( !valid )
+							continue;
+
+						if( needsOwner )
+						{
+							const Object* owner = GetOwner( resolved[numTags][i] );
+
+							for( unsigned k = 0U; owner && k < numTags; ++k )
+							{
+								if( excluded[k] )
+									valid = valid && !HasComponentType( *owner, types[k] );
+								else if( columns[k] == -1 )
+									resolved[k][i] = GetComponentByType( *owner, types[k] );
+							}
+
+							if( !owner || !valid )
+								continue;
+						}
+
+						std::apply( f, std::tuple_cat( QueryTraits< Tags >::Arg( resolved[Is][i] )... ) );
+					}
+				}
+			}
+
 		protected:
-			std::vector< ComponentsSet > m_components;
-			std::vector< Type > m_requiredComponentTypes;
+			ComponentsTable m_components;
+			std::vector< TypeId > m_requiredComponentTypes;
+			ComponentSignature m_requiredSignature;
+			ComponentSignature m_readSignature;
+			ComponentSignature m_writeSignature;
+			bool m_declaresAccess = false;
 
 		private:
+			// Membership is managed by World through these so the entry id -> slot lookup stays valid
+			unsigned AddEntry( const std::vector< BaseHandle >& handles );
+			void RemoveEntry( const unsigned entryId );
+			ComponentsSet GetEntry( const unsigned entryId ) const;
+			void CompactEntries();
+			void ClearEntries();
+
+			enum : unsigned { InvalidEntry = 0xFFFFFFFF };
+
 			World& m_world;
+
+			// Stable id of the entry in each slot of m_components (InvalidEntry for tombstones) and the reverse lookup
+			std::vector< unsigned > m_entryIds;
+			std::vector< unsigned > m_entrySlots;
+			std::vector< unsigned > m_freeEntryIds;
+			unsigned m_numTombstones = 0U;
+
+			// Scratch buffers for ReorderEntries
+			ComponentsTable m_reorderedComponents;
+			std::vector< unsigned > m_reorderedIds;
 		};
+
+		// Dense id for each system type, indexes World's system list
+		template< class T >
+		TypeId GetSystemTypeId() { return TypeIdGenerator< System >::Get< T >(); }
 	}
 }
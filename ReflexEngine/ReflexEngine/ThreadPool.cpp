@@ -0,0 +1,185 @@
+#include "ThreadPool.h"
+
+namespace Reflex
+{
+	namespace Core
+	{
+		namespace
+		{
+			thread_local unsigned s_threadIndex = 0U;
+			thread_local bool s_runningJobs = false;
+
+			uint64_t PackRange( const unsigned begin, const unsigned end ) { return ( ( uint64_t )end << 32 ) | begin; }
+			unsigned RangeBegin( const uint64_t range ) { return ( unsigned )range; }
+			unsigned RangeEnd( const uint64_t range ) { return ( unsigned )( range >> 32 ); }
+		}
+
+		ThreadPool::ThreadPool( unsigned numWorkers )
+		{
+			if( !numWorkers )
+				numWorkers = std::max( 1U, std::thread::hardware_concurrency() ) - 1U;
+
+			m_ranges.reset( new JobRange[numWorkers + 1U] );
+
+			for( unsigned i = 0U; i < numWorkers; ++i )
+				m_workers.emplace_back( &ThreadPool::WorkerLoop, this, i + 1U );
+		}
+
+		ThreadPool::~ThreadPool()
+		{
+			{
+				std::lock_guard< std::mutex > lock( m_mutex );
+				m_shutdown = true;
+			}
+
+			m_wake.notify_all();
+
+			for( auto& worker : m_workers )
+				worker.join();
+		}
+
+		void ThreadPool::Dispatch( const unsigned count, const std::function< void( const unsigned ) >& job )
+		{
+			// Not worth waking anyone up for (or we are already inside a batch)
+			if( m_workers.empty() || count <= 1U || s_runningJobs )
+			{
+				for( unsigned i = 0U; i < count; ++i )
+					job( i );
+				return;
+			}
+
+			{
+				std::lock_guard< std::mutex > lock( m_mutex );
+				m_job = &job;
+				m_count = count;
+
+				// Contiguous even shares, so neighbouring jobs (EG. ParallelFor ranges) mostly run on the same thread
+				const unsigned numThreads = GetNumThreads();
+				for( unsigned thread = 0U; thread < numThreads; ++thread )
+					m_ranges[thread].range = PackRange( ( unsigned )( ( uint64_t )count * thread / numThreads ), ( unsigned )( ( uint64_t )count * ( thread + 1U ) / numThreads ) );
+				m_activeWorkers = ( unsigned )m_workers.size();
+				++m_generation;
+			}
+
+			m_wake.notify_all();
+			RunJobs();
+
+			std::unique_lock< std::mutex > lock( m_mutex );
+			m_done.wait( lock, [this]() { return m_activeWorkers == 0U; } );
+			m_job = nullptr;
+		}
+
+		void ThreadPool::ParallelFor( const unsigned count, const unsigned grainSize, const std::function< void( const unsigned, const unsigned ) >& f )
+		{
+			const unsigned grain = std::max( 1U, grainSize );
+
+			Dispatch( ( count + grain - 1U ) / grain, [&]( const unsigned range )
+			{
+				const unsigned begin = range * grain;
+				f( begin, std::min( count, begin + grain ) );
+			} );
+		}
+
+		unsigned ThreadPool::GetNumWorkers() const
+		{
+			return ( unsigned )m_workers.size();
+		}
+
+		unsigned ThreadPool::GetNumThreads() const
+		{
+			return GetNumWorkers() + 1U;
+		}
+
+		unsigned ThreadPool::GetThreadIndex()
+		{
+			return s_threadIndex;
+		}
+
+		void ThreadPool::WorkerLoop( const unsigned threadIndex )
+		{
+			s_threadIndex = threadIndex;
+			unsigned generation = 0U;
+
+			while( true )
+			{
+				{
+					std::unique_lock< std::mutex > lock( m_mutex );
+					m_wake.wait( lock, [&]() { return m_shutdown || m_generation != generation; } );
+
+					if( m_shutdown )
+						return;
+
+					generation = m_generation;
+				}
+
+				RunJobs();
+
+				std::lock_guard< std::mutex > lock( m_mutex );
+				if( --m_activeWorkers == 0U )
+					m_done.notify_one();
+			}
+		}
+
+		void ThreadPool::RunJobs()
+		{
+			s_runningJobs = true;
+
+			const unsigned thread = s_threadIndex;
+			unsigned job = 0U;
+
+			// Our own share first, then help whoever still has work left
+			while( PopJob( thread, job ) || StealJob( thread, job ) )
+				( *m_job )( job );
+
+			s_runningJobs = false;
+		}
+
+		bool ThreadPool::PopJob( const unsigned thread, unsigned& job )
+		{
+			auto& range = m_ranges[thread].range;
+			auto current = range.load();
+
+			// Taken from the front, thieves take from the back
+			while( RangeBegin( current ) < RangeEnd( current ) )
+			{
+				if( range.compare_exchange_weak( current, PackRange( RangeBegin( current ) + 1U, RangeEnd( current ) ) ) )
+				{
+					job = RangeBegin( current );
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool ThreadPool::StealJob( const unsigned thread, unsigned& job )
+		{
+			const unsigned numThreads = GetNumThreads();
+
+			// Start with the next thread along, so thieves spread out over the victims
+			for( unsigned offset = 1U; offset < numThreads; ++offset )
+			{
+				auto& victim = m_ranges[( thread + offset ) % numThreads].range;
+				auto current = victim.load();
+
+				while( RangeBegin( current ) < RangeEnd( current ) )
+				{
+					// Half of what is left (rounded up), the first of them is run straight away and the rest becomes our share
+					const auto begin = RangeBegin( current );
+					const auto end = RangeEnd( current );
+					const auto split = end - ( end - begin + 1U ) / 2U;
+
+					if( victim.compare_exchange_weak( current, PackRange( begin, split ) ) )
+					{
+						// Nobody else writes to our share while it is empty, only thieves which see it as empty
+						m_ranges[thread].range = PackRange( split + 1U, end );
+						job = split;
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Precompiled.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace Reflex
+{
+	namespace Core
+	{
+		// Fixed set of worker threads which run batches of jobs
+		// The thread calling Dispatch works on the batch as well and blocks until all of it is done
+		class ThreadPool : private sf::NonCopyable
+		{
+		public:
+			// Zero workers picks one less than the number of hardware threads (the caller makes up the last one)
+			ThreadPool( unsigned numWorkers = 0U );
+			~ThreadPool();
+
+			// Runs job( i ) for every i in [0, count), returns once every job has finished
+			// Each thread starts with an even share of the jobs, threads that run out steal half of the remaining jobs of another thread
+			// Only one thread may dispatch at a time, a job that dispatches again just runs the inner batch itself
+			void Dispatch( const unsigned count, const std::function< void( const unsigned ) >& job );
+
+			// Splits [0, count) into ranges of grainSize and calls f( begin, end ) for each range through Dispatch
+			void ParallelFor( const unsigned count, const unsigned grainSize, const std::function< void( const unsigned, const unsigned ) >& f );
+
+			// Number of worker threads, not counting the caller
+			unsigned GetNumWorkers() const;
+
+			// Worker threads plus the caller, the upper bound of GetThreadIndex
+			unsigned GetNumThreads() const;
+
+			// 0 for the thread calling Dispatch (or any thread outside the pool), 1 to GetNumWorkers() for the workers
+			static unsigned GetThreadIndex();
+
+		private:
+			void WorkerLoop( const unsigned threadIndex );
+			void RunJobs();
+
+			// Jobs [begin, end) still to be run by a thread, packed into one word so the owner and thieves can both claim with a single CAS
+			bool PopJob( const unsigned thread, unsigned& job );
+			bool StealJob( const unsigned thread, unsigned& job );
+
+		private:
+			std::vector< std::thread > m_workers;
+
+			std::mutex m_mutex;
+			std::condition_variable m_wake;
+			std::condition_variable m_done;
+
+			// Current batch, only changed under m_mutex while no worker is running it
+			const std::function< void( const unsigned ) >* m_job = nullptr;
+			unsigned m_count = 0U;
+
+			// Indexed by GetThreadIndex, padded so threads don't share cache lines
+			struct alignas( 64 ) JobRange
+			{
+				std::atomic< uint64_t > range{ 0U };
+			};
+
+			std::unique_ptr< JobRange[] > m_ranges;
+			unsigned m_activeWorkers = 0U;
+			unsigned m_generation = 0U;
+			bool m_shutdown = false;
+		};
+	}
+}
\ No newline at end of file
@@ -2,13 +2,40 @@
 
 #include "TransformComponent.h"
 #include "Object.h"
-
-TODO( "Allow TileMap work when a pos outside the bounds is entered - dynamically resize the array" )
+#include "ThreadPool.h"
 
 namespace Reflex
 {
 	namespace Core
 	{
+		namespace
+		{
+			// Marks an unused slot by its id, every packed key is a real cell (( -1, -1 ) packs to all ones)
+			const unsigned EmptyCellID = 0xFFFFFFFF;
+			const unsigned MinCompactCellsThreshold = 64U;
+
+			uint64_t PackCell( const sf::Vector2i& cell )
+			{
+				return uint64_t( uint32_t( cell.x ) ) << 32 | uint32_t( cell.y );
+			}
+
+			sf::Vector2i UnpackCell( const uint64_t key )
+			{
+				return sf::Vector2i( int( uint32_t( key >> 32 ) ), int( uint32_t( key ) ) );
+			}
+
+			void ExpandRange( sf::Vector2i& min, sf::Vector2i& max, const sf::Vector2i& cell, const bool empty )
+			{
+				min = empty ? cell : sf::Vector2i( std::min( min.x, cell.x ), std::min( min.y, cell.y ) );
+				max = empty ? cell : sf::Vector2i( std::max( max.x, cell.x ), std::max( max.y, cell.y ) );
+			}
+
+			unsigned HashCellKey( const uint64_t key, const size_t tableSize )
+			{
+				return unsigned( ( key * 0x9E3779B97F4A7C15ULL ) >> 32 ) & unsigned( tableSize - 1U );
+			}
+		}
+
 		TileMap::TileMap( const sf::FloatRect& worldBounds )
 			: m_worldBounds( worldBounds )
 			//, m_tileMapGridSize( tileMapGridSize )
@@ -23,60 +50,512 @@ namespace Reflex
 		}
 
 		void TileMap::Insert( const ObjectHandle& obj )
+		{
+			if( obj && m_spacialHashMapSize )
+				Insert( obj, sf::FloatRect( obj->GetTransform()->GetWorldPosition(), sf::Vector2f() ) );
+		}
+
+		void TileMap::Insert( const ObjectHandle& obj, const sf::FloatRect& boundary )
 		{
 			if( obj && m_spacialHashMapSize )
 			{
-				const auto position = obj->GetComponent< Reflex::Components::Transform >()->GetWorldPosition();
-				Insert( obj, sf::FloatRect( position, sf::Vector2f( 0.0f, 0.0f ) ) );
+				Register( obj );
+
+				// Kept relative so the bounds move with the object
+				auto transform = obj->GetTransform();
+				const auto position = transform->GetWorldPosition();
+				transform->m_tileMapBounds = sf::FloatRect( boundary.left - position.x, boundary.top - position.y, boundary.width, boundary.height );
+
+				// Contiguous storage picks it up on the next rebuild
+				if( m_storageMode == StorageMode::Contiguous )
+					return;
+
+				const auto range = GetCellRange( *transform.Get() );
+				MoveCells( obj, GetStoredCells( *transform.Get() ), range );
+				SetStoredCells( *transform.Get(), range );
 			}
 		}
 
-		void TileMap::Insert( const ObjectHandle& obj, const sf::FloatRect& boundary )
+		void TileMap::Remove( const ObjectHandle& obj )
 		{
 			if( obj && m_spacialHashMapSize )
 			{
-				const auto ids = GetID( boundary );
+				auto transform = obj->GetTransform();
 
-				for( auto& id : ids )
+				if( transform->m_tileMapIndex != -1 )
 				{
-					if( id == -1 )
-						continue;
+					// Swap with the last so removing is constant time
+					const auto index = transform->m_tileMapIndex;
+					m_objects[index] = m_objects.back();
+					m_objects[index]->GetTransform()->m_tileMapIndex = index;
+					m_objects.pop_back();
+					transform->m_tileMapIndex = -1;
+				}
 
+				const auto range = GetStoredCells( *transform.Get() );
+
+				if( m_storageMode == StorageMode::Contiguous )
+				{
+					// Leave null entries behind until the next rebuild
+					ForEachCellID( range, [&]( const unsigned id )
+					{
+						if( id + 1U < m_cellStarts.size() )
+							for( unsigned i = m_cellStarts[id]; i < m_cellStarts[id + 1U]; ++i )
+								if( m_entries[i].object == obj )
+									m_entries[i].object = ObjectHandle::null;
+					} );
+				}
+				else
+				{
+					RemoveFromCells( obj, range );
+				}
+
+				SetStoredCells( *transform.Get(), CellRange() );
+				transform->m_tileMapBounds = sf::FloatRect();
+			}
+		}
+
+		void TileMap::Register( const ObjectHandle& obj )
+		{
+			auto transform = obj->GetTransform();
+
+			if( transform->m_tileMapIndex == -1 )
+			{
+				transform->m_tileMapIndex = ( unsigned )m_objects.size();
+				m_objects.push_back( obj );
+			}
+		}
+
+		void TileMap::RemoveFromCells( const ObjectHandle& obj, const CellRange& range )
+		{
+			ForEachCellID( range, [&]( const unsigned id )
+			{
+				if( id < m_spacialHashMap.size() )
+				{
 					auto& bucket = m_spacialHashMap[id];
-					bucket.insert( obj );
+					const auto found = bucket.find( obj );
+					assert( found != bucket.end() );
+					if( found != bucket.end() )
+						bucket.erase( found );
+				}
+			} );
+		}
+
+		void TileMap::MoveCells( const ObjectHandle& obj, const CellRange& from, const CellRange& to )
+		{
+			if( from == to )
+				return;
+
+			// Only the cells entering or leaving the range are touched, the overlap stays as it is
+			for( int y = from.min.y; y <= from.max.y; ++y )
+			{
+				for( int x = from.min.x; x <= from.max.x; ++x )
+				{
+					const sf::Vector2i cell( x, y );
+					const auto id = GetCellID( cell );
+
+					if( id < m_spacialHashMap.size() && !to.Contains( cell ) )
+						m_spacialHashMap[id].erase( obj );
+				}
+			}
+
+			for( int y = to.min.y; y <= to.max.y; ++y )
+			{
+				for( int x = to.min.x; x <= to.max.x; ++x )
+				{
+					const sf::Vector2i cell( x, y );
+
+					if( from.Contains( cell ) )
+						continue;
+
+					const auto id = AcquireCellID( cell );
+
+					if( id != -1 )
+						m_spacialHashMap[id].insert( obj );
 				}
 			}
 		}
 
-		void TileMap::Remove( const ObjectHandle& obj )
+		TileMap::Entry TileMap::GetEntry( const ObjectHandle& obj ) const
 		{
-			if( obj && m_spacialHashMapSize )
+			const auto transform = obj->GetTransform();
+			return Entry{ obj, transform->GetWorldPosition(), transform->m_tileMapIndex };
+		}
+
+		TileMap::QueryStamps& TileMap::BeginQuery() const
+		{
+			const auto thread = ThreadPool::GetThreadIndex();
+			assert( thread < m_queryStamps.size() );
+			auto& stamps = m_queryStamps[thread];
+
+			// Wrapped around, old stamps could match again
+			if( ++stamps.current == 0U )
 			{
-				const auto id = GetID( obj );
+				std::fill( stamps.stamps.begin(), stamps.stamps.end(), 0U );
+				stamps.current = 1U;
+			}
 
-				if( id == -1 )
-					return;
+			return stamps;
+		}
+
+		TileMap::CellRange TileMap::GetCellRange( const sf::FloatRect& boundary ) const
+		{
+			CellRange range;
+
+			if( !m_spacialHashMapSize )
+				return range;
+
+			auto left = boundary.left;
+			auto top = boundary.top;
+			auto right = boundary.left + boundary.width;
+			auto bottom = boundary.top + boundary.height;
+
+			if( m_gridMode == GridMode::Bounded )
+			{
+				// Nothing outside the bounds is stored, so clip to them (and to the grid for the far edges)
+				left = std::max( left, m_worldBounds.left );
+				top = std::max( top, m_worldBounds.top );
+				right = std::min( right, m_worldBounds.left + m_worldBounds.width );
+				bottom = std::min( bottom, m_worldBounds.top + m_worldBounds.height );
+
+				if( right < left || bottom < top )
+					return range;
 
-				auto& bucket = m_spacialHashMap[id];
-				const auto found = bucket.find( obj );
-				assert( found != bucket.end() );
-				if( found != bucket.end() )
-					bucket.erase( found );
+				range.min = Hash( sf::Vector2f( left, top ) );
+				range.max = Hash( sf::Vector2f( right, bottom ) );
+				range.min.x = std::max( range.min.x, 0 );
+				range.min.y = std::max( range.min.y, 0 );
+				range.max.x = std::min( range.max.x, ( int )m_spacialHashMapWidth - 1 );
+				range.max.y = std::min( range.max.y, ( int )m_spacialHashMapHeight - 1 );
+				return range;
 			}
+
+			range.min = Hash( sf::Vector2f( left, top ) );
+			range.max = Hash( sf::Vector2f( right, bottom ) );
+			return range;
+		}
+
+		TileMap::CellRange TileMap::GetCellRange( const Reflex::Components::Transform& transform ) const
+		{
+			const auto position = transform.GetWorldPosition();
+			const auto& bounds = transform.m_tileMapBounds;
+			return GetCellRange( sf::FloatRect( bounds.left + position.x, bounds.top + position.y, bounds.width, bounds.height ) );
+		}
+
+		TileMap::CellRange TileMap::GetOccupiedCells() const
+		{
+			if( m_gridMode == GridMode::Unbounded )
+				return m_cellExtents;
+
+			CellRange range;
+			range.max = sf::Vector2i( ( int )m_spacialHashMapWidth - 1, ( int )m_spacialHashMapHeight - 1 );
+			return range;
 		}
 
-		void TileMap::RemoveByID( const ObjectHandle& obj, const unsigned id )
+		TileMap::CellRange TileMap::GetStoredCells( const Reflex::Components::Transform& transform )
 		{
-			if( obj && m_spacialHashMapSize && id < m_spacialHashMap.size() )
+			CellRange range;
+			range.min = transform.m_tileMapCellsMin;
+			range.max = transform.m_tileMapCellsMax;
+			return range;
+		}
+
+		void TileMap::SetStoredCells( Reflex::Components::Transform& transform, const CellRange& range )
+		{
+			transform.m_tileMapCellsMin = range.min;
+			transform.m_tileMapCellsMax = range.max;
+		}
+
+		void TileMap::SetThreadCount( const unsigned numThreads )
+		{
+			m_syncQueues.resize( std::max( 1U, numThreads ) );
+			m_queryStamps.resize( std::max( 1U, numThreads ) );
+		}
+
+		void TileMap::QueueSync( const ObjectHandle& obj )
+		{
+			const auto thread = ThreadPool::GetThreadIndex();
+			assert( thread < m_syncQueues.size() );
+			m_syncQueues[thread].push_back( obj );
+		}
+
+		void TileMap::SetStorageMode( const StorageMode storageMode )
+		{
+			if( storageMode == m_storageMode )
+				return;
+
+			m_storageMode = storageMode;
+
+			if( m_storageMode == StorageMode::Contiguous )
+			{
+				if( m_gridMode == GridMode::Unbounded )
+					m_spacialHashMap.clear();
+				else
+					for( auto& bucket : m_spacialHashMap )
+						bucket.clear();
+
+				Rebuild();
+			}
+			else
 			{
-				auto& bucket = m_spacialHashMap[id];
-				const auto found = bucket.find( obj );
-				assert( found != bucket.end() );
-				if( found != bucket.end() )
-					bucket.erase( found );
+				m_entries.clear();
+				m_cellStarts.clear();
+
+				// Contiguous cells only live until the next rebuild, buckets get allocated along with their cells
+				if( m_gridMode == GridMode::Unbounded )
+					ClearCells();
+
+				for( auto& obj : m_objects )
+				{
+					auto transform = obj->GetTransform();
+					const auto range = GetCellRange( *transform.Get() );
+					MoveCells( obj, CellRange(), range );
+					SetStoredCells( *transform.Get(), range );
+				}
 			}
 		}
 
+		TileMap::StorageMode TileMap::GetStorageMode() const
+		{
+			return m_storageMode;
+		}
+
+		void TileMap::SetGridMode( const GridMode gridMode )
+		{
+			if( gridMode == m_gridMode )
+				return;
+
+			m_gridMode = gridMode;
+			Reset( true );
+		}
+
+		TileMap::GridMode TileMap::GetGridMode() const
+		{
+			return m_gridMode;
+		}
+
+		void TileMap::Rebuild()
+		{
+			// Unbounded cells are allocated afresh every rebuild, so only cells occupied right now exist
+			if( m_gridMode == GridMode::Unbounded )
+				ClearCells();
+
+			const auto numObjects = ( unsigned )m_objects.size();
+
+			// Vectors keep their capacity, so once the sizes settle a rebuild doesn't allocate
+			m_unsortedEntries.resize( numObjects );
+			m_unsortedRanges.resize( numObjects );
+
+			for( unsigned i = 0U; i < numObjects; ++i )
+			{
+				auto transform = m_objects[i]->GetTransform();
+				const auto range = GetCellRange( *transform.Get() );
+
+				// Allocate the cells up front so the count below knows how many there are
+				if( m_gridMode == GridMode::Unbounded )
+					for( int y = range.min.y; y <= range.max.y; ++y )
+						for( int x = range.min.x; x <= range.max.x; ++x )
+							AcquireCellID( sf::Vector2i( x, y ) );
+
+				SetStoredCells( *transform.Get(), range );
+				m_unsortedEntries[i] = Entry{ m_objects[i], transform->GetWorldPosition(), i };
+				m_unsortedRanges[i] = range;
+			}
+
+			// Count the objects in each cell (offset by one so the prefix sum below leaves each cell's start in place)
+			const auto numCells = m_gridMode == GridMode::Unbounded ? ( unsigned )m_cellKeys.size() : m_spacialHashMapWidth * m_spacialHashMapHeight;
+			m_cellStarts.assign( numCells + 1U, 0U );
+
+			for( const auto& range : m_unsortedRanges )
+				ForEachCellID( range, [this]( const unsigned id ) { ++m_cellStarts[id + 1U]; } );
+
+			for( unsigned id = 1U; id <= numCells; ++id )
+				m_cellStarts[id] += m_cellStarts[id - 1U];
+
+			// Scatter each object into the range of every cell it overlaps
+			m_entries.resize( m_cellStarts[numCells] );
+			m_cellCursors.assign( m_cellStarts.begin(), m_cellStarts.end() - 1 );
+
+			for( unsigned i = 0U; i < numObjects; ++i )
+				ForEachCellID( m_unsortedRanges[i], [&]( const unsigned id ) { m_entries[m_cellCursors[id]++] = m_unsortedEntries[i]; } );
+		}
+
+		void TileMap::Sync()
+		{
+			if( m_storageMode == StorageMode::Contiguous )
+			{
+				// Everything gets rebuilt anyway, the queues only need emptying
+				for( auto& queue : m_syncQueues )
+				{
+					for( auto& obj : queue )
+						if( obj )
+							obj->GetTransform()->m_spatialSyncQueued = false;
+
+					queue.clear();
+				}
+
+				if( m_spacialHashMapSize )
+					Rebuild();
+
+				return;
+			}
+
+			// Queued flags stay set until every queue is done, so a walk can tell which descendants are queued themselves
+			for( auto& queue : m_syncQueues )
+			{
+				for( auto& obj : queue )
+				{
+					// Destroyed objects are taken out by World::DeletePendingItems
+					if( !obj || obj->IsDestroyed() )
+						continue;
+
+					// Moving a parent moves its children too
+					m_syncStack.push_back( obj );
+
+					while( !m_syncStack.empty() )
+					{
+						const auto node = m_syncStack.back();
+						m_syncStack.pop_back();
+
+						// Queued descendants are walked from their own entry, so each node is only visited once
+						auto transform = node->GetTransform();
+						transform->ForEachChild( [this]( const ObjectHandle& child )
+						{
+							if( !child->GetTransform()->m_spatialSyncQueued )
+								m_syncStack.push_back( child );
+						} );
+
+						// Never inserted (or removed since)
+						if( !m_spacialHashMapSize || transform->m_tileMapIndex == -1 )
+							continue;
+
+						const auto from = GetStoredCells( *transform.Get() );
+						const auto to = GetCellRange( *transform.Get() );
+
+						if( from == to )
+							continue;
+
+						MoveCells( node, from, to );
+						SetStoredCells( *transform.Get(), to );
+					}
+				}
+			}
+
+			for( auto& queue : m_syncQueues )
+			{
+				for( auto& obj : queue )
+					if( obj )
+						obj->GetTransform()->m_spatialSyncQueued = false;
+
+				queue.clear();
+			}
+
+			if( m_gridMode == GridMode::Unbounded && m_cellKeys.size() >= m_compactCellsThreshold )
+				CompactCells();
+		}
+
+		unsigned TileMap::FindKNearest( const sf::Vector2f& position, const unsigned k, ObjectHandle* out, const float maxDistance /*= std::numeric_limits< float >::max()*/ ) const
+		{
+			if( !m_spacialHashMapSize || !k || maxDistance < 0.0f )
+				return 0U;
+
+			const auto occupied = GetOccupiedCells();
+
+			if( occupied.IsEmpty() )
+				return 0U;
+
+			auto& stamps = BeginQuery();
+			auto& nearest = stamps.nearest;
+			nearest.clear();
+
+			const auto cellSize = ( float )m_spacialHashMapSize;
+			const auto maxDistanceSq = maxDistance < std::sqrt( std::numeric_limits< float >::max() ) ? maxDistance * maxDistance : std::numeric_limits< float >::max();
+			const sf::Vector2i centre( ( int )std::floor( position.x / cellSize ), ( int )std::floor( position.y / cellSize ) );
+
+			const auto visitCell = [&]( const int x, const int y )
+			{
+				const auto id = GetCellID( sf::Vector2i( x, y ) );
+
+				if( id == -1 )
+					return;
+
+				ForEachEntryInCell( id, [&]( const Entry& entry )
+				{
+					if( !stamps.Visit( entry.index ) )
+						return;
+
+					const auto offset = entry.position - position;
+					const auto distanceSq = offset.x * offset.x + offset.y * offset.y;
+
+					if( distanceSq > maxDistanceSq || ( nearest.size() == k && distanceSq >= nearest.back().first ) )
+						return;
+
+					// Kept sorted, k is expected to be small enough that shifting beats a heap
+					if( nearest.size() == k )
+						nearest.pop_back();
+
+					const auto candidate = std::make_pair( distanceSq, entry.object );
+					nearest.insert( std::upper_bound( nearest.begin(), nearest.end(), candidate, []( const auto& a, const auto& b ) { return a.first < b.first; } ), candidate );
+				} );
+			};
+
+			// Rings closer in than the occupied cells are empty, so start with the first one to reach them
+			const auto firstRing = std::max( std::max( 0, std::max( occupied.min.x - centre.x, centre.x - occupied.max.x ) ), std::max( occupied.min.y - centre.y, centre.y - occupied.max.y ) );
+
+			for( int ring = firstRing; ; ++ring )
+			{
+				const sf::Vector2i min( centre.x - ring, centre.y - ring );
+				const sf::Vector2i max( centre.x + ring, centre.y + ring );
+
+				// Rows along the top and bottom edges of the ring, then the columns between them (clipped to the occupied cells)
+				const auto left = std::max( min.x, occupied.min.x );
+				const auto right = std::min( max.x, occupied.max.x );
+				const auto top = std::max( min.y + 1, occupied.min.y );
+				const auto bottom = std::min( max.y - 1, occupied.max.y );
+
+				if( min.y >= occupied.min.y && min.y <= occupied.max.y )
+					for( int x = left; x <= right; ++x )
+						visitCell( x, min.y );
+
+				if( ring > 0 && max.y >= occupied.min.y && max.y <= occupied.max.y )
+					for( int x = left; x <= right; ++x )
+						visitCell( x, max.y );
+
+				if( min.x >= occupied.min.x && min.x <= occupied.max.x )
+					for( int y = top; y <= bottom; ++y )
+						visitCell( min.x, y );
+
+				if( ring > 0 && max.x >= occupied.min.x && max.x <= occupied.max.x )
+					for( int y = top; y <= bottom; ++y )
+						visitCell( max.x, y );
+
+				// Every cell has been searched
+				if( min.x <= occupied.min.x && min.y <= occupied.min.y && max.x >= occupied.max.x && max.y >= occupied.max.y )
+					break;
+
+				// Anything in a cell beyond this ring is at least as far away as the nearest edge of the searched square
+				const auto edge = std::max( 0.0f, std::min(
+					std::min( position.x - min.x * cellSize, ( max.x + 1 ) * cellSize - position.x ),
+					std::min( position.y - min.y * cellSize, ( max.y + 1 ) * cellSize - position.y ) ) );
+				const auto edgeSq = edge * edge;
+
+				if( edgeSq > maxDistanceSq || ( nearest.size() == k && edgeSq >= nearest.back().first ) )
+					break;
+			}
+
+			for( unsigned i = 0U; i < nearest.size(); ++i )
+				out[i] = nearest[i].second;
+
+			return ( unsigned )nearest.size();
+		}
+
+		void TileMap::FindKNearest( const sf::Vector2f& position, const unsigned k, std::vector< ObjectHandle >& out, const float maxDistance /*= std::numeric_limits< float >::max()*/ ) const
+		{
+			// Reusing the caller's capacity, so repeat queries don't allocate either
+			out.resize( k );
+			out.resize( FindKNearest( position, k, out.data(), maxDistance ) );
+		}
+
 		void TileMap::GetNearby( const ObjectHandle& obj, std::vector< ObjectHandle >& out ) const
 		{
 			ForEachNearby( obj, [&out]( const ObjectHandle& obj )
@@ -104,11 +583,43 @@ namespace Reflex
 		void TileMap::Reset( const bool shouldRePopulate /*= false*/ )
 		{
 			m_spacialHashMap.clear();
-			m_spacialHashMapWidth = ( unsigned )std::ceil( m_worldBounds.width / m_spacialHashMapSize );
-			m_spacialHashMapHeight = ( unsigned )std::ceil( m_worldBounds.height / m_spacialHashMapSize );
-			m_spacialHashMap.resize( m_spacialHashMapWidth * m_spacialHashMapHeight );
+			ClearCells();
+
+			if( m_gridMode == GridMode::Bounded )
+			{
+				m_spacialHashMapWidth = ( unsigned )std::ceil( m_worldBounds.width / m_spacialHashMapSize );
+				m_spacialHashMapHeight = ( unsigned )std::ceil( m_worldBounds.height / m_spacialHashMapSize );
+				m_spacialHashMap.resize( m_spacialHashMapWidth * m_spacialHashMapHeight );
+			}
+
+			m_entries.clear();
+			m_cellStarts.clear();
+
+			// Cell ids change with the size, so anything still inserted goes back in from scratch (or not at all)
+			std::vector< ObjectHandle > objects;
+			objects.swap( m_objects );
+
+			for( auto& obj : objects )
+			{
+				auto transform = obj->GetTransform();
+				transform->m_tileMapIndex = -1;
+				SetStoredCells( *transform.Get(), CellRange() );
+			}
+
+			if( shouldRePopulate )
+			{
+				// Keeping the bounds each object was inserted with
+				for( auto& obj : objects )
+				{
+					const auto transform = obj->GetTransform();
+					const auto position = transform->GetWorldPosition();
+					const auto& bounds = transform->m_tileMapBounds;
+					Insert( obj, sf::FloatRect( bounds.left + position.x, bounds.top + position.y, bounds.width, bounds.height ) );
+				}
 
-			TODO( "TileMap: Implement shouldRePopulate system from world" );
+				if( m_storageMode == StorageMode::Contiguous )
+					Rebuild();
+			}
 		}
 
 		void TileMap::Reset( const unsigned spacialHashMapSize, const bool shouldRePopulate /*= false*/ )
@@ -125,31 +636,129 @@ namespace Reflex
 
 		unsigned TileMap::GetID( const sf::Vector2f& position ) const
 		{
-			if( position.x < m_worldBounds.left || position.x > ( m_worldBounds.left + m_worldBounds.width ) ||
-				position.y < m_worldBounds.top || position.y > ( m_worldBounds.top + m_worldBounds.height ) ||
-				!m_spacialHashMapSize )
+			if( !m_spacialHashMapSize )
+				return -1;
+
+			if( m_gridMode == GridMode::Bounded && (
+				position.x < m_worldBounds.left || position.x > ( m_worldBounds.left + m_worldBounds.width ) ||
+				position.y < m_worldBounds.top || position.y > ( m_worldBounds.top + m_worldBounds.height ) ) )
+				return -1;
+
+			return GetCellID( Hash( position ) );
+		}
+
+		sf::Vector2i TileMap::Hash( const sf::Vector2f& position ) const
+		{
+			// Unbounded cells can be negative, so round down rather than towards zero
+			if( m_gridMode == GridMode::Unbounded )
+				return sf::Vector2i( ( int )std::floor( position.x / m_spacialHashMapSize ), ( int )std::floor( position.y / m_spacialHashMapSize ) );
+
+			return sf::Vector2i( int( position.x / m_spacialHashMapSize ), int( position.y / m_spacialHashMapSize ) );
+		}
+
+		unsigned TileMap::GetCellID( const sf::Vector2i& cell ) const
+		{
+			if( m_gridMode == GridMode::Bounded )
+			{
+				if( cell.x < 0 || cell.y < 0 || cell.x >= ( int )m_spacialHashMapWidth || cell.y >= ( int )m_spacialHashMapHeight )
+					return -1;
+
+				return cell.y * m_spacialHashMapWidth + cell.x;
+			}
+
+			if( m_cellTable.empty() )
 				return -1;
 
-			const auto loc = Hash( position );
-			return loc.y * m_spacialHashMapWidth + loc.x;
+			const auto key = PackCell( cell );
+
+			for( auto slot = HashCellKey( key, m_cellTable.size() ); ; slot = ( slot + 1U ) & unsigned( m_cellTable.size() - 1U ) )
+			{
+				if( m_cellTable[slot].id == EmptyCellID )
+					return -1;
+
+				if( m_cellTable[slot].key == key )
+					return m_cellTable[slot].id;
+			}
 		}
 
-		std::vector< unsigned > TileMap::GetID( const sf::FloatRect& boundary ) const
+		unsigned TileMap::AcquireCellID( const sf::Vector2i& cell )
 		{
-			const auto locTopLeft = Hash( sf::Vector2f( boundary.left, boundary.top ) );
-			const auto locBotRight = Hash( sf::Vector2f( boundary.left + boundary.width, boundary.top + boundary.height ) );
-			std::vector< unsigned > ids;
+			if( m_gridMode == GridMode::Bounded )
+				return GetCellID( cell );
+
+			// Keep the table at most half full so probes stay short
+			if( ( m_cellKeys.size() + 1U ) * 2U > m_cellTable.size() )
+				RehashCells( std::max< size_t >( 16U, m_cellTable.size() * 2U ) );
+
+			const auto key = PackCell( cell );
+			auto slot = HashCellKey( key, m_cellTable.size() );
 
-			for( int x = locTopLeft.x; x <= locBotRight.x; ++x )
-				for( int y = locTopLeft.y; y <= locBotRight.y; ++y )
-					ids.push_back( y * m_spacialHashMapWidth+ x );
+			for( ; m_cellTable[slot].id != EmptyCellID; slot = ( slot + 1U ) & unsigned( m_cellTable.size() - 1U ) )
+				if( m_cellTable[slot].key == key )
+					return m_cellTable[slot].id;
 
-			return std::move( ids );
+			const auto id = ( unsigned )m_cellKeys.size();
+			m_cellTable[slot] = CellSlot{ key, id };
+			m_cellKeys.push_back( key );
+			ExpandRange( m_cellExtents.min, m_cellExtents.max, cell, m_cellExtents.IsEmpty() );
+
+			if( m_storageMode == StorageMode::Buckets )
+				m_spacialHashMap.emplace_back();
+
+			return id;
 		}
 
-		sf::Vector2i TileMap::Hash( const sf::Vector2f& position ) const
+		void TileMap::ClearCells()
 		{
-			return sf::Vector2i( int( position.x / m_spacialHashMapSize ), int( position.y / m_spacialHashMapSize ) );
+			std::fill( m_cellTable.begin(), m_cellTable.end(), CellSlot{ 0U, EmptyCellID } );
+			m_cellKeys.clear();
+			m_cellExtents = CellRange();
+			m_compactCellsThreshold = MinCompactCellsThreshold;
+		}
+
+		void TileMap::RehashCells( const size_t tableSize )
+		{
+			m_cellTable.assign( tableSize, CellSlot{ 0U, EmptyCellID } );
+
+			// Ids stay the same, only the slots move
+			for( unsigned id = 0U; id < m_cellKeys.size(); ++id )
+			{
+				auto slot = HashCellKey( m_cellKeys[id], m_cellTable.size() );
+
+				while( m_cellTable[slot].id != EmptyCellID )
+					slot = ( slot + 1U ) & unsigned( m_cellTable.size() - 1U );
+
+				m_cellTable[slot] = CellSlot{ m_cellKeys[id], id };
+			}
+		}
+
+		void TileMap::CompactCells()
+		{
+			// Drop the empty buckets left behind by objects moving on, renumbering the rest
+			unsigned numCells = 0U;
+			m_cellExtents = CellRange();
+
+			for( unsigned id = 0U; id < m_cellKeys.size(); ++id )
+			{
+				if( m_spacialHashMap[id].empty() )
+					continue;
+
+				// Objects remember their cells by coordinates, so nothing else needs updating
+				if( id != numCells )
+				{
+					m_spacialHashMap[numCells] = std::move( m_spacialHashMap[id] );
+					m_cellKeys[numCells] = m_cellKeys[id];
+				}
+
+				ExpandRange( m_cellExtents.min, m_cellExtents.max, UnpackCell( m_cellKeys[numCells] ), numCells == 0U );
+				++numCells;
+			}
+
+			m_spacialHashMap.resize( numCells );
+			m_cellKeys.resize( numCells );
+			RehashCells( m_cellTable.size() );
+
+			m_compactCellsThreshold = std::max( MinCompactCellsThreshold, numCells * 2U );
 		}
 	}
 }
\ No newline at end of file
@@ -11,11 +11,32 @@ namespace Reflex
 		class TileMap : sf::NonCopyable
 		{
 			friend class Reflex::Components::Transform;
+			friend class SceneNode;
 
 		public:
+			// Buckets: a hash set per cell, kept up to date incrementally by Sync so only objects that moved cost anything
+			// Contiguous: Sync counting sorts every object into one flat array by cell, for scenes where most objects move every frame
+			// Contiguous entries also hold the position each object had at the time, and are only rebuilt by Sync
+			enum class StorageMode : char
+			{
+				Buckets,
+				Contiguous,
+			};
+
+			// Bounded: a dense array with a cell for every spacialHashMapSize square of the world bounds, anything outside the bounds isn't stored
+			// Unbounded: cells are allocated as objects move into them and found through a hash table on their coordinates
+			// Objects can then go anywhere, and memory follows the occupied area rather than the size of the world
+			enum class GridMode : char
+			{
+				Bounded,
+				Unbounded,
+			};
+
 			explicit TileMap( const sf::FloatRect& worldBounds );
 			explicit TileMap( const sf::FloatRect& worldBounds, const unsigned spacialHashMapSize );
 
+			// Objects are stored in every cell their bounds overlap, and the bounds follow the object's world position as it moves (rotation and scale aren't applied)
+			// Insert( obj ) treats the object as a point, inserting an object again changes its bounds (touching only the cells that enter or leave its range)
 			void Insert( const ObjectHandle& obj );
 			void Insert( const ObjectHandle& obj,  const sf::FloatRect& boundary );
 			void Remove( const ObjectHandle& obj );
@@ -27,22 +48,140 @@ namespace Reflex
 			template< typename Func >
 			void ForEachNearby( const ObjectHandle& obj, Func f ) const;
 
+			// Only the one cell position falls in, see ForEachInRadius for everything within a distance
 			template< typename Func >
 			void ForEachNearby( const sf::Vector2f& position, Func f ) const;
 
+			// Objects overlapping several of the cells are still only reported once
+			// Not reentrant, f shouldn't run another multi-cell query on the same thread
 			template< typename Func >
 			void ForEachNearby( const ObjectHandle& obj, const sf::FloatRect& boundary, Func f ) const;
 
+			// Exact queries, objects are tested by position (the position Sync last saw for contiguous storage, the cached world position for buckets)
+			// Neither allocates once the per thread query state has grown to the number of objects, and neither is reentrant (as above)
+			template< typename Func >
+			void ForEachInRadius( const sf::Vector2f& position, const float radius, Func f ) const;
+
+			template< typename Func >
+			void ForEachInRect( const sf::FloatRect& rect, Func f ) const;
+
+			// Writes up to k objects nearest to position (and no further than maxDistance) into out, nearest first, and returns how many were found
+			// Searches rings of cells outward from position's cell, stopping once no unsearched cell could hold anything nearer
+			unsigned FindKNearest( const sf::Vector2f& position, const unsigned k, ObjectHandle* out, const float maxDistance = std::numeric_limits< float >::max() ) const;
+			void FindKNearest( const sf::Vector2f& position, const unsigned k, std::vector< ObjectHandle >& out, const float maxDistance = std::numeric_limits< float >::max() ) const;
+
 			void Reset( const bool shouldRePopulate = false );
 			void Reset( const unsigned spacialHashMapSize, const bool shouldRePopulate = false );
 
+			void SetStorageMode( const StorageMode storageMode );
+			StorageMode GetStorageMode() const;
+
+			// Changing the grid mode re-inserts every object
+			void SetGridMode( const GridMode gridMode );
+			GridMode GetGridMode() const;
+
+			// One sync queue per thread, so transforms can be changed from parallel systems
+			void SetThreadCount( const unsigned numThreads );
+
+			// Moves every object whose transform changed since the last call (along with all of their descendants) into its new cell
+			// World::Update calls this once per frame after world transforms have been resolved, so cells are only stale within a frame
+			void Sync();
+
 		protected:
-			void RemoveByID( const ObjectHandle& obj, const unsigned id );
+			// Inclusive range of cell coordinates, empty when max is less than min
+			struct CellRange
+			{
+				sf::Vector2i min;
+				sf::Vector2i max = sf::Vector2i( -1, -1 );
+
+				bool IsEmpty() const { return max.x < min.x || max.y < min.y; }
+				bool Contains( const sf::Vector2i& cell ) const { return cell.x >= min.x && cell.x <= max.x && cell.y >= min.y && cell.y <= max.y; }
+				bool operator==( const CellRange& other ) const { return min == other.min && max == other.max; }
+				bool operator!=( const CellRange& other ) const { return !( *this == other ); }
+			};
+
+			// An object as seen by a query, index is its position in m_objects (which query stamps are kept by)
+			struct Entry
+			{
+				ObjectHandle object;
+				sf::Vector2f position;
+				unsigned index;
+			};
+
+			// Marks objects already reported by the current query, one set per thread so queries can run in parallel
+			// Also holds the candidates of FindKNearest (sorted by squared distance) so they don't need allocating every query
+			struct QueryStamps
+			{
+				bool Visit( const unsigned index )
+				{
+					if( index >= stamps.size() )
+						stamps.resize( index + 1U, 0U );
+
+					if( stamps[index] == current )
+						return false;
+
+					stamps[index] = current;
+					return true;
+				}
+
+				unsigned current = 0U;
+				std::vector< unsigned > stamps;
+				std::vector< std::pair< float, ObjectHandle > > nearest;
+			};
+
+			void QueueSync( const ObjectHandle& obj );
+
+			void Register( const ObjectHandle& obj );
+			void Rebuild();
+
+			// Calls f for every object stored in the given (valid) cell
+			template< typename Func >
+			void ForEachInCell( const unsigned id, Func f ) const;
+
+			// As ForEachInCell but with the whole Entry, bucket storage looks the position and index up through the object's transform
+			template< typename Func >
+			void ForEachEntryInCell( const unsigned id, Func f ) const;
+			Entry GetEntry( const ObjectHandle& obj ) const;
+
+			// Calls f( id ) for every cell in the range that exists
+			template< typename Func >
+			void ForEachCellID( const CellRange& range, Func f ) const;
+
+			// Calls f( entry ) once for every object stored in the range (however many of its cells it overlaps)
+			template< typename Func >
+			void ForEachEntry( const CellRange& range, Func f ) const;
+
+			// Starts a new query for the calling thread
+			QueryStamps& BeginQuery() const;
+
+			// Cells overlapped by a world space rect (only those inside the bounds when bounded)
+			CellRange GetCellRange( const sf::FloatRect& boundary ) const;
+			// Cells overlapped by an object's bounds at its current world position
+			CellRange GetCellRange( const Reflex::Components::Transform& transform ) const;
+
+			// Every cell that could hold an object, the grid when bounded and the extents of the allocated cells when not
+			CellRange GetOccupiedCells() const;
+
+			static CellRange GetStoredCells( const Reflex::Components::Transform& transform );
+			static void SetStoredCells( Reflex::Components::Transform& transform, const CellRange& range );
+
+			// Bucket storage
+			void RemoveFromCells( const ObjectHandle& obj, const CellRange& range );
+			void MoveCells( const ObjectHandle& obj, const CellRange& from, const CellRange& to );
+
 			unsigned GetID( const ObjectHandle& obj ) const;
 			unsigned GetID( const sf::Vector2f& position ) const;
-			std::vector< unsigned > GetID( const sf::FloatRect& boundary ) const;
 			sf::Vector2i Hash( const sf::Vector2f& position ) const;
 
+			// GetCellID returns -1 for cells outside the bounds or (when unbounded) cells not allocated yet, AcquireCellID allocates them instead
+			unsigned GetCellID( const sf::Vector2i& cell ) const;
+			unsigned AcquireCellID( const sf::Vector2i& cell );
+
+			// Unbounded cell table
+			void ClearCells();
+			void RehashCells( const size_t tableSize );
+			void CompactCells();
+
 		private:
 			const sf::FloatRect m_worldBounds;
 			unsigned m_spacialHashMapSize = 0U;
@@ -51,9 +190,115 @@ namespace Reflex
 			unsigned m_spacialHashMapWidth = 0U;
 			unsigned m_spacialHashMapHeight = 0U;
 			std::vector< std::unordered_set< ObjectHandle > > m_spacialHashMap;
+			StorageMode m_storageMode = StorageMode::Buckets;
+			GridMode m_gridMode = GridMode::Bounded;
+
+			// Unbounded cells, an open addressing table (linear probing, power of two size) from packed cell coordinates to cell id
+			// Unused slots are marked by their id, as any key is a valid cell
+			struct CellSlot
+			{
+				uint64_t key;
+				unsigned id;
+			};
+
+			std::vector< CellSlot > m_cellTable;
+			std::vector< uint64_t > m_cellKeys;
+			// Bucket storage keeps cells once allocated, so they are compacted whenever their number has doubled
+			unsigned m_compactCellsThreshold = 0U;
+			// Grows as cells are allocated and is only recalculated when they are cleared or compacted
+			CellRange m_cellExtents;
+
+			// Every inserted object (whatever the storage mode), each Transform knows its index (m_tileMapIndex)
+			std::vector< ObjectHandle > m_objects;
+
+			// Contiguous storage, the entries of cell id are m_entries[m_cellStarts[id], m_cellStarts[id + 1])
+			std::vector< Entry > m_entries;
+			std::vector< unsigned > m_cellStarts;
+
+			// Scratch for Rebuild
+			std::vector< Entry > m_unsortedEntries;
+			std::vector< CellRange > m_unsortedRanges;
+			std::vector< unsigned > m_cellCursors;
+
+			// Objects queued by SceneNode::OnTransformChanged, indexed by ThreadPool::GetThreadIndex
+			std::vector< std::vector< ObjectHandle > > m_syncQueues = std::vector< std::vector< ObjectHandle > >( 1U );
+			std::vector< ObjectHandle > m_syncStack;
+
+			// Indexed by ThreadPool::GetThreadIndex
+			mutable std::vector< QueryStamps > m_queryStamps = std::vector< QueryStamps >( 1U );
 		};
 
 		// Template function definitions
+		template< typename Func >
+		void TileMap::ForEachInCell( const unsigned id, Func f ) const
+		{
+			if( m_storageMode == StorageMode::Contiguous )
+			{
+				// Not built yet
+				if( id + 1U >= m_cellStarts.size() )
+					return;
+
+				// Entries removed since the last rebuild are left behind as null handles
+				for( unsigned i = m_cellStarts[id]; i < m_cellStarts[id + 1U]; ++i )
+					if( m_entries[i].object != ObjectHandle::null )
+						f( m_entries[i].object );
+			}
+			else
+			{
+				for( auto& item : m_spacialHashMap[id] )
+					f( item );
+			}
+		}
+
+		template< typename Func >
+		void TileMap::ForEachEntryInCell( const unsigned id, Func f ) const
+		{
+			if( m_storageMode == StorageMode::Contiguous )
+			{
+				if( id + 1U >= m_cellStarts.size() )
+					return;
+
+				for( unsigned i = m_cellStarts[id]; i < m_cellStarts[id + 1U]; ++i )
+					if( m_entries[i].object != ObjectHandle::null )
+						f( m_entries[i] );
+			}
+			else
+			{
+				for( auto& item : m_spacialHashMap[id] )
+					f( GetEntry( item ) );
+			}
+		}
+
+		template< typename Func >
+		void TileMap::ForEachCellID( const CellRange& range, Func f ) const
+		{
+			for( int y = range.min.y; y <= range.max.y; ++y )
+			{
+				for( int x = range.min.x; x <= range.max.x; ++x )
+				{
+					const auto id = GetCellID( sf::Vector2i( x, y ) );
+
+					if( id != -1 )
+						f( id );
+				}
+			}
+		}
+
+		template< typename Func >
+		void TileMap::ForEachEntry( const CellRange& range, Func f ) const
+		{
+			auto& stamps = BeginQuery();
+
+			ForEachCellID( range, [&]( const unsigned id )
+			{
+				ForEachEntryInCell( id, [&]( const Entry& entry )
+				{
+					if( stamps.Visit( entry.index ) )
+						f( entry );
+				} );
+			} );
+		}
+
 		template< typename Func >
 		void TileMap::ForEachNearby( const ObjectHandle& obj, Func f ) const
 		{
@@ -64,11 +309,11 @@ namespace Reflex
 				if( id == -1 )
 					return;
 
-				auto& bucket = m_spacialHashMap[id];
-
-				for( auto& item : bucket )
+				ForEachInCell( id, [&]( const ObjectHandle& item )
+				{
 					if( item != obj )
 						f( item );
+				} );
 			}
 		}
 
@@ -82,10 +327,7 @@ namespace Reflex
 				if( id == -1 )
 					return;
 
-				auto& bucket = m_spacialHashMap[id];
-
-				for( auto& item : bucket )
-					f( item );
+				ForEachInCell( id, f );
 			}
 		}
 
@@ -94,19 +336,42 @@ namespace Reflex
 		{
 			if( obj && m_spacialHashMapSize )
 			{
-				const auto ids = GetID( boundary );
+				ForEachEntry( GetCellRange( boundary ), [&]( const Entry& entry )
+				{
+					if( entry.object != obj )
+						f( entry.object );
+				} );
+			}
+		}
+
+		template< typename Func >
+		void TileMap::ForEachInRadius( const sf::Vector2f& position, const float radius, Func f ) const
+		{
+			if( m_spacialHashMapSize && radius >= 0.0f )
+			{
+				const auto radiusSq = radius * radius;
 
-				for( auto& id : ids )
+				ForEachEntry( GetCellRange( sf::FloatRect( position.x - radius, position.y - radius, radius * 2.0f, radius * 2.0f ) ), [&]( const Entry& entry )
 				{
-					if( id == -1 )
-						continue;
+					const auto offset = entry.position - position;
 
-					auto& bucket = m_spacialHashMap[id];
+					if( offset.x * offset.x + offset.y * offset.y <= radiusSq )
+						f( entry.object );
+				} );
+			}
+		}
 
-					for( auto& item : bucket )
-						if( item != obj )
-							f( item );
-				}
+		template< typename Func >
+		void TileMap::ForEachInRect( const sf::FloatRect& rect, Func f ) const
+		{
+			if( m_spacialHashMapSize )
+			{
+				ForEachEntry( GetCellRange( rect ), [&]( const Entry& entry )
+				{
+					if( entry.position.x >= rect.left && entry.position.x <= rect.left + rect.width &&
+						entry.position.y >= rect.top && entry.position.y <= rect.top + rect.height )
+						f( entry.object );
+				} );
 			}
 		}
 	}
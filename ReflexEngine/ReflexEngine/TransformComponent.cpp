@@ -8,7 +8,7 @@ namespace Reflex
 	{
 		Transform::Transform( const sf::Vector2f& position /*= sf::Vector2f()*/, const float rotation /*= 0.0f*/, const sf::Vector2f& scale /*= sf::Vector2f( 1.0f, 1.0f )*/ )
 		{
-			sf::Transformable::setPosition( position );
+			SceneNode::setPosition( position );
 			setRotation( rotation );
 			setScale( scale );
 		}
@@ -23,40 +23,23 @@ namespace Reflex
 
 		}
 
-		void Transform::OnConstructionComplete()
-		{
-			m_object->GetWorld().GetTileMap().Insert( m_object, sf::FloatRect( GetWorldPosition(), sf::Vector2f( 0.0f, 0.0f ) ) );
-		}
-
-		void Transform::setPosition( float x, float y )
-		{
-			Transform::setPosition( sf::Vector2f( x, y ) );
-		}
-
-		void Transform::setPosition( const sf::Vector2f& position )
+		Transform::Transform( Transform&& other )
+			: SceneNode( std::move( other ) )
+			, Component( other )
+			, m_rotateDegreesPerSec( other.m_rotateDegreesPerSec )
+			, m_rotateDurationSec( other.m_rotateDurationSec )
+			, m_finishedRotationCallback( std::move( other.m_finishedRotationCallback ) )
+			, m_tileMapCellsMin( other.m_tileMapCellsMin )
+			, m_tileMapCellsMax( other.m_tileMapCellsMax )
+			, m_tileMapBounds( other.m_tileMapBounds )
+			, m_tileMapIndex( other.m_tileMapIndex )
 		{
-			auto& tileMap = m_object->GetWorld().GetTileMap();
-			const auto previousID = tileMap.GetID( m_object );
-
-			sf::Transformable::setPosition( position );
-
-			const auto newID = tileMap.GetID( m_object );
 
-			if( previousID != newID )
-			{
-				tileMap.RemoveByID( m_object, previousID );
-				tileMap.Insert( m_object );
-			}
 		}
 
-		void Transform::move( float offsetX, float offsetY )
-		{
-			Transform::move( sf::Vector2f( offsetX, offsetY ) );
-		}
-
-		void Transform::move( const sf::Vector2f& offset )
+		void Transform::OnConstructionComplete()
 		{
-			setPosition( getPosition() + offset );
+			m_object->GetWorld().GetTileMap().Insert( m_object );
 		}
 
 		void Transform::SetOwningObject( const ObjectHandle& owner )
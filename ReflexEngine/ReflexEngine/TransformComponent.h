@@ -13,6 +13,7 @@ namespace Reflex
 
 	namespace Core
 	{
+		class TileMap;
 		typedef Handle< class Reflex::Components::Transform > TransformHandle;
 	}
 
@@ -22,19 +23,16 @@ namespace Reflex
 		{
 		public:
 			friend class Reflex::Systems::MovementSystem;
+			friend class Reflex::Core::TileMap;
 
 			Transform( const sf::Vector2f& position = sf::Vector2f(), const float rotation = 0.0f, const sf::Vector2f& scale = sf::Vector2f( 1.0f, 1.0f ) );
 			Transform( const Transform& other );
+			Transform( Transform&& other );
 
 			void OnConstructionComplete() final;
 
-			void setPosition( float x, float y );
-			void setPosition( const sf::Vector2f& position );
-
-			void move( float offsetX, float offsetY );
-			void move( const sf::Vector2f& offset );
-
 			void RotateForDuration( const float degrees, const float durationSec );
+			// The callback runs during MovementSystem's update, any structural changes it makes must be recorded with World::GetCommandBuffer
 			void RotateForDuration( const float degrees, const float durationSec, std::function< void( const TransformHandle& ) > finishedRotationCallback );
 			void StopRotation();
 
@@ -44,6 +42,14 @@ namespace Reflex
 			float m_rotateDegreesPerSec = 0.0f;
 			float m_rotateDurationSec = 0.0f;
 			std::function< void( const TransformHandle& ) > m_finishedRotationCallback;
+
+			// TileMap cells this object is currently stored in (inclusive, empty when max is less than min), kept up to date by TileMap::Sync
+			sf::Vector2i m_tileMapCellsMin;
+			sf::Vector2i m_tileMapCellsMax = sf::Vector2i( -1, -1 );
+			// Bounds in the TileMap relative to the world position
+			sf::FloatRect m_tileMapBounds;
+			// Position in the TileMap's list of inserted objects
+			unsigned m_tileMapIndex = ( unsigned )-1;
 		};
 	}
 }
\ No newline at end of file
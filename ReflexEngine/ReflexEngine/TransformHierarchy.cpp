@@ -0,0 +1,234 @@
+#include "TransformHierarchy.h"
+#include "Object.h"
+#include "ThreadPool.h"
+
+namespace Reflex
+{
+	namespace Core
+	{
+		void TransformHierarchy::SetRoot( const TransformHandle& root )
+		{
+			if( m_root )
+				RemoveSubtree( *m_root.Get() );
+
+			m_root = root;
+			AddSubtree( *root.Get(), NoParent );
+		}
+
+		void TransformHierarchy::Update()
+		{
+			if( !m_transformsDirty )
+				return;
+
+			Gather();
+
+			if( !m_work.empty() )
+			{
+				Compose();
+				Scatter();
+			}
+
+			m_transformsDirty = false;
+		}
+
+		void TransformHierarchy::OnTransformsChanged()
+		{
+			m_transformsDirty = true;
+		}
+
+		bool TransformHierarchy::HasChanges() const
+		{
+			return m_transformsDirty;
+		}
+
+		void TransformHierarchy::AddSubtree( SceneNode& node, const unsigned parentSlot )
+		{
+			assert( !node.m_hierarchy );
+
+			unsigned slot = ( unsigned )m_nodes.size();
+
+			if( !m_freeSlots.empty() )
+			{
+				slot = m_freeSlots.back();
+				m_freeSlots.pop_back();
+			}
+			else
+			{
+				m_nodes.emplace_back();
+				m_parents.push_back( NoParent );
+				m_depths.push_back( 0U );
+				m_world.push_back( Reflex::Affine2D() );
+				m_worldTranslations.emplace_back();
+				m_worldScales.emplace_back();
+				m_worldRotations.push_back( 0.0f );
+				m_queued.push_back( 0 );
+			}
+
+			m_nodes[slot] = node.m_owningObject->GetTransform();
+			m_parents[slot] = parentSlot;
+			m_depths[slot] = parentSlot == NoParent ? 0U : m_depths[parentSlot] + 1U;
+			node.m_hierarchySlot = slot;
+			node.m_hierarchy = this;
+
+			// Our world values depend on the new parent
+			node.m_worldTransformDirty = true;
+			QueueDirty( node );
+			m_transformsDirty = true;
+
+			node.ForEachChild( [&]( const ObjectHandle& child ) { AddSubtree( *child->GetTransform().Get(), slot ); } );
+		}
+
+		void TransformHierarchy::RemoveSubtree( SceneNode& node )
+		{
+			if( !node.m_hierarchy )
+				return;
+
+			// Any queued entry is skipped by Gather (or picked up by whichever node reuses the slot)
+			m_nodes[node.m_hierarchySlot] = TransformHandle::null;
+			m_freeSlots.push_back( node.m_hierarchySlot );
+			node.m_hierarchy = nullptr;
+
+			node.ForEachChild( [&]( const ObjectHandle& child ) { RemoveSubtree( *child->GetTransform().Get() ); } );
+		}
+
+		void TransformHierarchy::QueueDirty( const SceneNode& node )
+		{
+			if( !node.m_hierarchy )
+				return;
+
+			const auto slot = node.m_hierarchySlot;
+
+			if( m_queued[slot] )
+				return;
+
+			m_queued[slot] = 1;
+			m_dirty.push_back( slot );
+		}
+
+		void TransformHierarchy::SetThreadCount( const unsigned numThreads )
+		{
+			m_parallelChanges.resize( std::max( 1U, numThreads ) );
+		}
+
+		void TransformHierarchy::QueueParallelChange( const ObjectHandle& obj )
+		{
+			const auto thread = ThreadPool::GetThreadIndex();
+			assert( thread < m_parallelChanges.size() );
+			m_parallelChanges[thread].push_back( obj );
+		}
+
+		void TransformHierarchy::PropagateParallelChanges()
+		{
+			for( auto& queue : m_parallelChanges )
+			{
+				for( auto& obj : queue )
+				{
+					if( !obj )
+						continue;
+
+					auto transform = obj->GetTransform();
+					QueueDirty( *transform.Get() );
+					transform->ForEachChild( []( const ObjectHandle& child ) { child->GetTransform()->MarkWorldTransformDirty(); } );
+				}
+
+				queue.clear();
+			}
+		}
+
+		void TransformHierarchy::Gather()
+		{
+			m_work.clear();
+			m_workLevels.clear();
+			m_resolved.clear();
+			m_locals.clear();
+
+			// Parents are always shallower than their children
+			std::sort( m_dirty.begin(), m_dirty.end(), [this]( const unsigned left, const unsigned right )
+			{
+				return m_depths[left] != m_depths[right] ? m_depths[left] < m_depths[right] : left < right;
+			} );
+
+			for( const auto slot : m_dirty )
+			{
+				m_queued[slot] = 0;
+
+				if( !m_nodes[slot] )
+					continue;
+
+				auto* node = m_nodes[slot].Get();
+
+				// Already resolved lazily, just bring our copy of its world values up to date
+				if( !node->m_worldTransformDirty )
+				{
+					m_world.Set( slot, node->m_worldAffine );
+					m_worldTranslations[slot] = node->m_worldTranslation;
+					m_worldScales[slot] = node->m_worldScale;
+					m_worldRotations[slot] = node->m_worldRotation;
+					continue;
+				}
+
+				if( m_work.empty() || m_depths[slot] != m_depths[m_work.back()] )
+					m_workLevels.push_back( ( unsigned )m_work.size() );
+
+				m_work.push_back( slot );
+				m_resolved.push_back( node );
+				m_locals.push_back( Reflex::Affine2D::FromTransform( node->getTransform() ) );
+			}
+
+			m_workLevels.push_back( ( unsigned )m_work.size() );
+			m_dirty.clear();
+		}
+
+		void TransformHierarchy::Compose()
+		{
+			m_parentWorlds.resize( m_locals.size() );
+
+			for( unsigned level = 0U; level + 1U < m_workLevels.size(); ++level )
+			{
+				const auto begin = m_workLevels[level];
+				const auto end = m_workLevels[level + 1U];
+
+				// Every parent is on a level above, so nodes in the same level never depend on each other
+				for( unsigned k = begin; k < end; ++k )
+				{
+					const auto parent = m_parents[m_work[k]];
+					m_parentWorlds.Set( k, parent == NoParent ? Reflex::Affine2D() : m_world.Get( parent ) );
+				}
+
+				Reflex::ComposeAffines( m_parentWorlds.GetView( begin ), m_locals.GetView( begin ), m_locals.GetView( begin ), end - begin );
+
+				for( unsigned k = begin; k < end; ++k )
+					m_world.Set( m_work[k], m_locals.Get( k ) );
+			}
+		}
+
+		void TransformHierarchy::Scatter()
+		{
+			// In depth order, so a parent's world values are always up to date by the time its children read them
+			for( unsigned k = 0U; k < m_work.size(); ++k )
+			{
+				const auto slot = m_work[k];
+				auto* transform = m_resolved[k];
+
+				auto translation = transform->getPosition();
+				auto scale = transform->getScale();
+				auto rotation = transform->getRotation();
+
+				if( m_parents[slot] != NoParent )
+				{
+					const auto parent = m_parents[slot];
+					translation += m_worldTranslations[parent];
+					rotation += m_worldRotations[parent];
+					scale.x *= m_worldScales[parent].x;
+					scale.y *= m_worldScales[parent].y;
+				}
+
+				m_worldTranslations[slot] = transform->m_worldTranslation = translation;
+				m_worldScales[slot] = transform->m_worldScale = scale;
+				m_worldRotations[slot] = transform->m_worldRotation = rotation;
+				transform->m_worldAffine = m_world.Get( slot );
+				transform->m_worldTransformDirty = false;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Precompiled.h"
+#include "TransformComponent.h"
+
+#include <atomic>
+
+namespace Reflex
+{
+	namespace Core
+	{
+		// Resolves every dirty world transform under a root in one pass (World::Update runs it once per frame)
+		// Every node under the root has a persistent slot holding its parent, depth and world values in SoA arrays, kept up to date as nodes are attached and detached
+		// Nodes queue their slot when they become dirty, Update sorts the queue by depth and composes a level at a time with the ComposeAffines batch kernel
+		class TransformHierarchy : private sf::NonCopyable
+		{
+		public:
+			void SetRoot( const TransformHandle& root );
+			void Update();
+
+			// Called by SceneNode for nodes in this hierarchy's world, lets Update skip frames where nothing moved (safe from any thread)
+			void OnTransformsChanged();
+			bool HasChanges() const;
+
+			// Called by SceneNode when a node is attached under a node in the hierarchy or unlinked from one, only the node's own subtree is visited
+			void AddSubtree( SceneNode& node, const unsigned parentSlot );
+			void RemoveSubtree( SceneNode& node );
+
+			// Called by SceneNode when a node in the hierarchy goes from clean to dirty
+			void QueueDirty( const SceneNode& node );
+
+			// Nodes changed while systems run in parallel only mark themselves dirty, as their descendants may belong to another thread
+			// They are queued here (one queue per thread) and their descendants are marked by PropagateParallelChanges once the parallel work is over
+			void SetThreadCount( const unsigned numThreads );
+			void QueueParallelChange( const ObjectHandle& obj );
+			void PropagateParallelChanges();
+
+		private:
+			void Gather();
+			void Compose();
+			void Scatter();
+
+		private:
+			enum : unsigned { NoParent = 0xFFFFFFFF };
+
+			TransformHandle m_root;
+			std::atomic< bool > m_transformsDirty{ true };
+
+			// By slot, m_nodes[slot] is null for free slots
+			std::vector< TransformHandle > m_nodes;
+			std::vector< unsigned > m_parents;
+			std::vector< unsigned > m_depths;
+			std::vector< unsigned > m_freeSlots;
+
+			// World values by slot, clean parents are read from here instead of from their node
+			Reflex::Affine2DArray m_world;
+			std::vector< sf::Vector2f > m_worldTranslations;
+			std::vector< sf::Vector2f > m_worldScales;
+			std::vector< float > m_worldRotations;
+
+			// Slots waiting for Update, m_queued stops a slot being added twice
+			std::vector< unsigned > m_dirty;
+			std::vector< char > m_queued;
+
+			// Indexed by ThreadPool::GetThreadIndex
+			std::vector< std::vector< ObjectHandle > > m_parallelChanges = std::vector< std::vector< ObjectHandle > >( 1U );
+
+			// Dirty nodes by work index (in depth order), m_workLevels[i] is the first work index of the i'th depth with any dirty nodes
+			std::vector< unsigned > m_work;
+			std::vector< unsigned > m_workLevels;
+			std::vector< Reflex::Components::Transform* > m_resolved;
+			// By work index, the locals are composed in place into world affines
+			Reflex::Affine2DArray m_locals;
+			Reflex::Affine2DArray m_parentWorlds;
+		};
+	}
+}
\ No newline at end of file
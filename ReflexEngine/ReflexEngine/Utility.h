@@ -13,6 +13,26 @@ namespace Reflex
 	namespace Core
 	{
 		typedef std::type_index Type;
+
+		// Dense zero based id, handed out per Family the first time each type asks for one
+		typedef unsigned TypeId;
+
+		template< class Family >
+		class TypeIdGenerator
+		{
+		public:
+			template< class T >
+			static TypeId Get()
+			{
+				static const TypeId id = s_nextId++;
+				return id;
+			}
+
+			static TypeId Count() { return s_nextId; }
+
+		private:
+			inline static TypeId s_nextId = 0U;
+		};
 	}
 
 	// Math common
@@ -11,23 +11,25 @@ namespace Reflex
 {
 	namespace Core
 	{
-		World::World( Context context, sf::FloatRect worldBounds, const unsigned initialMaxObjects )
+		World::World( Context context, sf::FloatRect worldBounds, const unsigned initialMaxObjects, const StorageMode storageMode )
 			: m_context( context )
 			, m_worldView( context.window->getDefaultView() )
 			, m_worldBounds( worldBounds )
-			, m_objects( sizeof( Object ), initialMaxObjects )
-			, m_components( 10 )
+			, m_objects( initialMaxObjects, EntityAllocator::GrowthMode::Paged )
+			, m_storageMode( storageMode )
+			, m_archetypes( *context.handleManager )
 			, m_tileMap( m_worldBounds )
 		{
 			Setup();
 		}
 
-		World::World( Context context, sf::FloatRect worldBounds, const unsigned spacialHashMapSize, const unsigned initialMaxObjects )
+		World::World( Context context, sf::FloatRect worldBounds, const unsigned spacialHashMapSize, const unsigned initialMaxObjects, const StorageMode storageMode )
 			: m_context( context )
 			, m_worldView( context.window->getDefaultView() )
 			, m_worldBounds( worldBounds )
-			, m_objects( sizeof( Object ), initialMaxObjects )
-			, m_components( 10 )
+			, m_objects( initialMaxObjects, EntityAllocator::GrowthMode::Paged )
+			, m_storageMode( storageMode )
+			, m_archetypes( *context.handleManager )
 			, m_tileMap( m_worldBounds, spacialHashMapSize )
 		{
 			Setup();
@@ -40,54 +42,131 @@ namespace Reflex
 
 		void World::Setup()
 		{
+			const unsigned numThreads = m_context.threadPool ? m_context.threadPool->GetNumThreads() : 1U;
+			for( unsigned i = 0U; i < numThreads; ++i )
+				m_commandBuffers.push_back( std::make_unique< CommandBuffer >() );
+
+			m_tileMap.SetThreadCount( numThreads );
+			m_transformHierarchy.SetThreadCount( numThreads );
+
 			AddSystem< Reflex::Systems::RenderSystem >();
 			AddSystem< Reflex::Systems::InteractableSystem >();
 			AddSystem< Reflex::Systems::MovementSystem >();
 
 			m_sceneGraphRoot = CreateObject( false )->GetTransform();
+			m_transformHierarchy.SetRoot( m_sceneGraphRoot );
 		}
 
 		void World::Update( const float deltaTime )
 		{
-			// Update systems
-			for( auto& system : m_systems )
-				system.second->Update( deltaTime );
+			// Update systems, stage by stage
+			for( auto& stage : m_updateStages )
+			{
+				if( stage.size() == 1U || !m_context.threadPool )
+				{
+					for( auto* system : stage )
+						system->Update( deltaTime );
+				}
+				else
+				{
+					LockStructuralChanges();
+
+					m_context.threadPool->Dispatch( ( unsigned )stage.size(), [&stage, deltaTime]( const unsigned i )
+					{
+						stage[i]->Update( deltaTime );
+					} );
+
+					UnlockStructuralChanges();
+				}
+			}
+
+			// Sync point for structural changes recorded during the update
+			PlaybackCommands();
 
 			// Deleting objects
 			DeletePendingItems();
+
+			// Ordered systems leave gaps when entries are removed, close them up once per frame
+			for( auto& system : m_systems )
+				if( system )
+					system->CompactEntries();
+
+			// Resolve world transforms in one pass so rendering and spatial queries only read cached values
+			m_transformHierarchy.Update();
+
+			// Bring the spatial index up to date with everything that moved this frame
+			m_tileMap.Sync();
 		}
 
 		void World::ProcessEvent( const sf::Event& event )
 		{
 			for( auto& system : m_systems )
-				system.second->ProcessEvent( event );
+				if( system )
+					system->ProcessEvent( event );
 		}
 
 		void World::DeletePendingItems()
 		{
-			if( !m_markedForDeletion.empty() )
+			if( m_markedForDeletion.empty() )
+				return;
+
+			// Detaching is constant time, so each object can simply unhook itself from its parent
+			for( auto& objectHandle : m_markedForDeletion )
 			{
-				for( auto& objectHandle : m_markedForDeletion )
-				{
-					auto* object = objectHandle.Get();
+				auto transform = objectHandle->GetTransform();
+				if( const auto parent = transform->GetParent() )
+					parent->GetTransform()->DetachChild( objectHandle );
+			}
 
-					// Detach from parent
-					const auto parent = object->GetTransform()->GetParent();
-					if( parent )
-						parent->GetTransform()->DetachChild( objectHandle );
+			// The whole object is going, so every system entry it has can be dropped without checking which components it holds
+			m_deletionComponents.clear();
+			for( auto& objectHandle : m_markedForDeletion )
+			{
+				auto* object = objectHandle.Get();
 
-					GetHandleManager().Remove( objectHandle );
-					object->RemoveAllComponents();
-					object->~Object();
-					auto moved = ( Object* )m_objects.Release( object );
+				m_tileMap.Remove( objectHandle );
 
-					// Sync handle of potentially moved object
-					if( moved )
-						GetHandleManager().Update( moved );
-				}
+				for( auto& entry : object->m_systemEntries )
+					entry.first->RemoveEntry( entry.second );
+
+				object->m_systemEntries.clear();
+
+				if( m_storageMode == StorageMode::Archetype )
+					m_archetypes.RemoveObject( *object );
+				else
+					m_deletionComponents.insert( m_deletionComponents.end(), object->m_components.begin(), object->m_components.end() );
+
+				object->m_components.clear();
+				object->m_signature.reset();
+			}
+
+			// Work through one pool at a time
+			std::stable_sort( m_deletionComponents.begin(), m_deletionComponents.end(), []( const std::pair< TypeId, BaseHandle >& left, const std::pair< TypeId, BaseHandle >& right )
+			{
+				return left.first < right.first;
+			} );
 
-				m_markedForDeletion.clear();
+			for( auto& component : m_deletionComponents )
+				DestroyPooledComponent( component.first, component.second );
+
+			for( auto& objectHandle : m_markedForDeletion )
+			{
+				auto* object = objectHandle.Get();
+				GetHandleManager().Remove( objectHandle );
+				object->~Object();
+				auto moved = ( Object* )m_objects.Release( object );
+
+				// Sync handle of potentially moved object
+				if( moved )
+				{
+					GetHandleManager().Update( moved );
+
+					if( m_storageMode == StorageMode::Archetype )
+						m_archetypes.OnObjectMoved( *moved );
+				}
 			}
+
+			m_markedForDeletion.clear();
 		}
 
 		void World::ResetAllocator( EntityAllocator& allocator )
@@ -110,9 +189,10 @@ namespace Reflex
 		{
 			m_context.window->setView( m_worldView );
 
-			for( auto iter = m_systems.begin(); iter != m_systems.end(); ++iter )
+			for( auto& system : m_systems )
 			{
-				m_context.window->draw( *iter->second );
+				if( system )
+					m_context.window->draw( *system );
 			}
 		}
 
@@ -123,6 +203,8 @@ namespace Reflex
 
 		ObjectHandle World::CreateObject( const bool attachToRoot, const sf::Vector2f& position, const float rotation, const sf::Vector2f& scale )
 		{
+			assert( !StructuralChangesLocked() );
+
 			// Allocate the component's memory from the allocator
 			Object* newObject = ( Object* )m_objects.Allocate();
 
@@ -143,13 +225,120 @@ namespace Reflex
 			return newHandle;
 		}
 
-		void World::DestroyObject( ObjectHandle object )
+		void World::DestroyObject( ObjectHandle object, const bool destroyChildren )
+		{
+			assert( !StructuralChangesLocked() );
+
+			auto* ptr = object.Get();
+
+			assert( ptr && !ptr->m_destroyed );
+			if( !ptr || ptr->m_destroyed )
+				return;
+
+			m_markedForDeletion.push_back( object );
+			ptr->m_destroyed = true;
+
+			if( !destroyChildren )
+				return;
+
+			// Children of a destroyed parent are detached in bulk by DeletePendingItems, so marking them is all that is needed
+			m_deletionStack.clear();
+			ptr->GetTransform()->ForEachChild( [this]( const ObjectHandle& child ) { m_deletionStack.push_back( child ); } );
+
+			while( !m_deletionStack.empty() )
+			{
+				const auto node = m_deletionStack.back();
+				m_deletionStack.pop_back();
+
+				auto* nodePtr = node.Get();
+				if( !nodePtr )
+					continue;
+
+				// Already destroyed (without its children) earlier on, its descendants still need marking
+				if( !nodePtr->m_destroyed )
+				{
+					m_markedForDeletion.push_back( node );
+					nodePtr->m_destroyed = true;
+				}
+
+				nodePtr->GetTransform()->ForEachChild( [this]( const ObjectHandle& child ) { m_deletionStack.push_back( child ); } );
+			}
+		}
+
+		CommandBuffer& World::GetCommandBuffer()
+		{
+			const auto thread = ThreadPool::GetThreadIndex();
+			assert( thread < m_commandBuffers.size() );
+			return *m_commandBuffers[thread];
+		}
+
+		void World::PlaybackCommands()
 		{
-			assert( !object.markedForDeletion );
-			if( !object.markedForDeletion )
+			assert( !StructuralChangesLocked() );
+
+			// Commands are played back from a scratch buffer, so anything recorded during playback (EG. by a component's constructor) goes into the emptied buffer
+			// Keep going until a round records nothing new, commands that keep recording more are left for the next frame
+			unsigned round = 0U;
+
+			for( bool played = true; played; ++round )
 			{
-				m_markedForDeletion.push_back( object );
-				object.markedForDeletion = true;
+				if( round == MaxPlaybackRounds )
+				{
+					// Only a problem if the last round recorded more
+					if( std::any_of( m_commandBuffers.begin(), m_commandBuffers.end(), []( const std::unique_ptr< CommandBuffer >& buffer ) { return !buffer->IsEmpty(); } ) )
+						LOG_CRIT( "Commands were still being recorded after " << ( unsigned )MaxPlaybackRounds << " rounds of playback" );
+
+					break;
+				}
+
+				played = false;
+
+				for( auto& buffer : m_commandBuffers )
+				{
+					if( buffer->IsEmpty() )
+						continue;
+
+					played = true;
+					buffer->Swap( m_playbackCommands );
+
+					m_playbackCreated.clear();
+					for( auto& create : m_playbackCommands.m_creates )
+						m_playbackCreated.push_back( CreateObject( create.position, create.rotation, create.scale ) );
+
+					// Group by type (keeping the recorded order within a type) so each type is added in one batch
+					auto& adds = m_playbackCommands.m_adds;
+					std::stable_sort( adds.begin(), adds.end(), []( const CommandBuffer::AddCommand& left, const CommandBuffer::AddCommand& right )
+					{
+						return left.type < right.type;
+					} );
+
+					for( unsigned begin = 0U, end = 0U; begin < adds.size(); begin = end )
+					{
+						while( end < adds.size() && adds[end].type == adds[begin].type )
+							++end;
+
+						adds[begin].playback( *this, adds.data() + begin, adds.data() + end, m_playbackCreated );
+					}
+
+					for( auto& remove : m_playbackCommands.m_removes )
+					{
+						const auto component = ComponentHandle( remove.second );
+						if( !component.IsValid() )
+							continue;
+
+						if( const auto owner = component->GetObject() )
+							owner->RemoveComponentInternal( remove.first, remove.second );
+					}
+
+					for( auto& destroy : m_playbackCommands.m_destroys )
+					{
+						const auto object = CommandBuffer::Resolve( destroy.first, m_playbackCreated );
+						if( object.IsValid() && !object->IsDestroyed() )
+							DestroyObject( object, destroy.second );
+					}
+
+					m_playbackCommands.Clear();
+				}
 			}
 		}
 
@@ -158,13 +347,41 @@ namespace Reflex
 			ResetAllocator( m_objects );
 
 			for( auto& allocator : m_components )
-				ResetAllocator( *allocator.second.get() );
+				if( allocator )
+					ResetAllocator( *allocator );
+
+			m_archetypes.Clear();
 
 			for( auto& system : m_systems )
-				system.second->m_components.clear();
+				if( system )
+					system->ClearEntries();
+		}
+
+		void World::DestroyComponent( TypeId componentType, BaseHandle component )
+		{
+			const auto owner = ComponentHandle( component )->GetObject();
+			assert( owner );
+			DestroyComponent( *owner.Get(), componentType, component );
 		}
 
-		void World::DestroyComponent( Type componentType, BaseHandle component )
+		void World::DestroyComponent( Object& owner, TypeId componentType, BaseHandle component )
+		{
+			assert( !StructuralChangesLocked() );
+
+			RemoveComponentFromSystems( owner, component );
+
+			if( m_storageMode == StorageMode::Archetype )
+			{
+				// Destroys the component and moves the owner's remaining components into their new archetype
+				m_archetypes.RemoveComponent( owner, component );
+				GetHandleManager().Remove( component );
+				return;
+			}
+
+			DestroyPooledComponent( componentType, component );
+		}
+
+		void World::DestroyPooledComponent( const TypeId componentType, const BaseHandle& component )
 		{
 			Entity* entity = GetHandleManager().GetAs< Entity >( component );
 			entity->~Entity();
@@ -174,25 +391,124 @@ namespace Reflex
 			// Sync handle of potentially moved object
 			if( moved )
 				GetHandleManager().Update( moved );
+		}
 
-			// Remove this component from any systems
-			for( auto iter = m_systems.begin(); iter != m_systems.end(); ++iter )
+		void World::RemoveComponentFromSystems( Object& owner, const BaseHandle& component )
+		{
+			// The owner knows every system entry it is part of, so only those need checking
+			auto& entries = owner.m_systemEntries;
+
+			for( unsigned i = 0U; i < entries.size(); )
 			{
-				const auto& requiredComponents = iter->second->m_requiredComponentTypes;
-				
-				if( std::find( requiredComponents.begin(), requiredComponents.end(), componentType ) == requiredComponents.end() )
+				auto* system = entries[i].first;
+				const auto entryId = entries[i].second;
+				const auto& set = system->GetEntry( entryId );
+
+				if( std::find( set.begin(), set.end(), component ) == set.end() )
+				{
+					++i;
 					continue;
+				}
+
+				system->RemoveEntry( entryId );
+				entries[i] = entries.back();
+				entries.pop_back();
+			}
+		}
+
+		void World::RebuildSystemsByComponentType()
+		{
+			m_systemsByComponentType.clear();
 
-				auto& componentsPerObject = iter->second->m_components;
+			for( auto& system : m_systems )
+			{
+				if( !system )
+					continue;
 
-				componentsPerObject.erase( std::remove_if( componentsPerObject.begin(), componentsPerObject.end(), [&component]( std::vector< BaseHandle >& components )
+				for( const auto type : system->m_requiredComponentTypes )
 				{
-					return std::find( components.begin(), components.end(), component ) != components.end();
-				} 
-				), componentsPerObject.end() );
+					if( type >= m_systemsByComponentType.size() )
+						m_systemsByComponentType.resize( type + 1 );
+
+					auto& systems = m_systemsByComponentType[type];
+
+					// A system may require the same type twice, only list it once
+					if( std::find( systems.begin(), systems.end(), system.get() ) == systems.end() )
+						systems.push_back( system.get() );
+				}
+			}
+		}
+
+		void World::RebuildUpdateStages()
+		{
+			m_updateStages.clear();
+
+			std::vector< std::pair< System*, unsigned > > scheduled;
+
+			for( auto& system : m_systems )
+			{
+				if( !system )
+					continue;
+
+				// Must come after every earlier system it conflicts with
+				unsigned stage = 0U;
+				for( auto& previous : scheduled )
+					if( system->ConflictsWith( *previous.first ) )
+						stage = std::max( stage, previous.second + 1U );
+
+				if( stage >= m_updateStages.size() )
+					m_updateStages.resize( stage + 1U );
+
+				m_updateStages[stage].push_back( system.get() );
+				scheduled.emplace_back( system.get(), stage );
 			}
 		}
 
+		World::StorageMode World::GetStorageMode() const
+		{
+			return m_storageMode;
+		}
+
+		void World::LockStructuralChanges()
+		{
+			// Only the first lock is taken from a single thread, nested ones come from systems already running in parallel
+			if( m_structuralLocks == 0U )
+				ResolveWorldTransforms();
+
+			++m_structuralLocks;
+		}
+
+		void World::UnlockStructuralChanges()
+		{
+			assert( m_structuralLocks );
+
+			// Back to a single thread, finish off the dirty marking transform changes skipped while running in parallel
+			if( --m_structuralLocks == 0U )
+				m_transformHierarchy.PropagateParallelChanges();
+		}
+
+		void World::ResolveWorldTransforms()
+		{
+			// World transforms are otherwise resolved lazily, which writes the cached values of the node and its ancestors
+			if( !m_transformHierarchy.HasChanges() )
+				return;
+
+			m_transformHierarchy.Update();
+
+			// Anything still dirty isn't under the scene graph root
+			ForEachObject( []( Object* object )
+			{
+				const auto transform = object->GetTransform();
+				if( transform && transform->IsWorldTransformDirty() )
+					transform->GetWorldAffine();
+			} );
+		}
+
+		bool World::StructuralChangesLocked() const
+		{
+			return m_structuralLocks != 0U;
+		}
+
 		HandleManager& World::GetHandleManager()
 		{
 			return *m_context.handleManager;
@@ -213,6 +529,11 @@ namespace Reflex
 			return m_tileMap;
 		}
 
+		TransformHierarchy& World::GetTransformHierarchy()
+		{
+			return m_transformHierarchy;
+		}
+
 		const sf::FloatRect World::GetBounds() const
 		{
 			return m_worldBounds;
@@ -223,60 +544,58 @@ namespace Reflex
 			return m_sceneGraphRoot->GetChild( index );
 		}
 
-		std::unordered_map< Type, std::unique_ptr< EntityAllocator > >::iterator World::GetComponentAllocator( const Type& componentType, const size_t componentSize )
+		void World::AddComponentToSystems( const ObjectHandle& owner, const BaseHandle& componentHandle, const TypeId componentType )
 		{
-			// Create an allocator for this type if one doesn't already exist
-			auto found = m_components.find( componentType );
+			if( componentType >= m_systemsByComponentType.size() )
+				return;
 
-			if( found == m_components.end() )
-			{
-				const auto result = m_components.insert( std::make_pair( componentType, std::make_unique< EntityAllocator >( componentSize, 1000 ) ) );
-				found = result.first;
+			// Only systems which require this type can be affected
+			for( auto* system : m_systemsByComponentType[componentType] )
+				AddComponentToSystem( *system, owner, componentHandle, componentType );
+		}
 
-				if( !result.second )
-					LOG_CRIT( "Failed to allocate memory for component allocator of type: " << componentType.name() );
-			}
+		void World::AddComponentsToSystems( const std::vector< std::pair< ObjectHandle, BaseHandle > >& added, const TypeId componentType )
+		{
+			if( componentType >= m_systemsByComponentType.size() )
+				return;
 
-			return found;
+			for( auto* system : m_systemsByComponentType[componentType] )
+				for( auto& component : added )
+					AddComponentToSystem( *system, component.first, component.second, componentType );
 		}
 
-		void World::AddComponentToSystems( const ObjectHandle& owner, const BaseHandle& componentHandle, const Type& componentType )
+		void World::AddComponentToSystem( System& system, const ObjectHandle& owner, const BaseHandle& componentHandle, const TypeId componentType )
 		{
-			// Here we want to check if we should add this component to any systems
-			for( auto iter = m_systems.begin(); iter != m_systems.end(); ++iter )
-			{
-				// If the system doesn't care about this type, skip it
-				const auto& requiredTypes = iter->second->m_requiredComponentTypes;
-				if( std::find( requiredTypes.begin(), requiredTypes.end(), componentType ) == requiredTypes.end() )
-					continue;
+			// Only if the object now has everything the system requires
+			const auto& requiredSignature = system.m_requiredSignature;
+			if( ( owner->m_signature & requiredSignature ) != requiredSignature )
+				return;
 
-				auto& componentsPerObject = iter->second->m_components;
+			const auto& requiredTypes = system.m_requiredComponentTypes;
 
-				std::vector< BaseHandle > tempList;
-				bool canAddDueToNewComponent = false;
+			m_systemEntryHandles.clear();
+			bool canAddDueToNewComponent = false;
 
-				// This looks through the required types and sees if the object has one of each of them
-				for( auto& requiredType : requiredTypes )
-				{
-					const auto handle = ( requiredType == componentType ? componentHandle : owner->GetComponent( requiredType ) );
+			// This looks through the required types and sees if the object has one of each of them
+			for( auto& requiredType : requiredTypes )
+			{
+				const auto handle = ( requiredType == componentType ? componentHandle : owner->GetComponentByType( requiredType ) );
 
-					if( !handle.IsValid() )
-						break;
+				if( !handle.IsValid() )
+					break;
 
-					if( handle == componentHandle )
-						canAddDueToNewComponent = true;
+				if( handle == componentHandle )
+					canAddDueToNewComponent = true;
 
-					tempList.push_back( handle );
-				}
+				m_systemEntryHandles.push_back( handle );
+			}
 
-				// Escape if the object didn't have the components required OR if our new component isn't even the one that is now allowing it to be a part of the system
-				if( tempList.size() < requiredTypes.size() || !canAddDueToNewComponent )
-					continue;
+			// Escape if the object didn't have the components required OR if our new component isn't even the one that is now allowing it to be a part of the system
+			if( m_systemEntryHandles.size() < requiredTypes.size() || !canAddDueToNewComponent )
+				return;
 
-				const auto insertionIter = iter->second->GetInsertionIndex( tempList );
-				iter->second->m_components.insert( insertionIter, std::move( tempList ) );
-				iter->second->OnComponentAdded();
-			}
+			owner->m_systemEntries.emplace_back( &system, system.AddEntry( m_systemEntryHandles ) );
+			system.OnComponentAdded();
 		}
 	}
 }
\ No newline at end of file
@@ -3,10 +3,13 @@
 #include "Precompiled.h"
 #include "ResourceManager.h"
 #include "Object.h"
-#include "EntityAllocator.h"
+#include "ComponentPool.h"
+#include "ArchetypeStorage.h"
 #include "System.h"
+#include "CommandBuffer.h"
 #include "HandleFwd.hpp"
 #include "TileMap.h"
+#include "TransformHierarchy.h"
 #include "Context.h"
 #include <assert.h>
 
@@ -16,16 +19,26 @@ namespace Reflex
 	namespace Core
 	{
 		using Systems::System;
+		using Systems::GetSystemTypeId;
 
 		// World class
 		class World : private sf::NonCopyable
 		{
 		public:
 			friend class Object;
+			friend class CommandBuffer;
 			friend class Reflex::Components::Grid;
 
-			explicit World( Context context, sf::FloatRect worldBounds, const unsigned initialMaxObjects );
-			explicit World( Context context, sf::FloatRect worldBounds, const unsigned spacialHashMapSize, const unsigned initialMaxObjects );
+			// Pooled: one pool per component type, systems reach components through handles
+			// Archetype: components of objects with the same component types are stored together in SoA chunks (see ForEachChunk)
+			enum class StorageMode : char
+			{
+				Pooled,
+				Archetype,
+			};
+
+			explicit World( Context context, sf::FloatRect worldBounds, const unsigned initialMaxObjects, const StorageMode storageMode = StorageMode::Pooled );
+			explicit World( Context context, sf::FloatRect worldBounds, const unsigned spacialHashMapSize, const unsigned initialMaxObjects, const StorageMode storageMode = StorageMode::Pooled );
 			~World();
 
 			void Setup();
@@ -36,10 +49,19 @@ namespace Reflex
 			ObjectHandle CreateObject( const sf::Vector2f& position = sf::Vector2f(), const float rotation = 0.0f, const sf::Vector2f& scale = sf::Vector2f( 1.0f, 1.0f ) );
 			ObjectHandle CreateObject( const bool attachToRoot, const sf::Vector2f& position = sf::Vector2f(), const float rotation = 0.0f, const sf::Vector2f& scale = sf::Vector2f( 1.0f, 1.0f ) );
 
-			void DestroyObject( ObjectHandle object );
+			// Objects are only marked here and actually deleted at the end of Update
+			// With destroyChildren the subtree is walked once and every descendant is marked as well (already destroyed ones are skipped)
+			void DestroyObject( ObjectHandle object, const bool destroyChildren = false );
 
 			void DestroyAllObjects();
 
+			// Buffer for the calling thread to record structural changes into, usable while structural changes are locked
+			// Recorded commands are applied by PlaybackCommands, which Update calls once all systems have been updated
+			CommandBuffer& GetCommandBuffer();
+
+			// Applies every recorded command, per buffer: objects are created, then components are added (batched by type), then removed, then objects destroyed
+			void PlaybackCommands();
+
 			template< class T, typename... Args >
 			T* AddSystem( Args&&... args );
 
@@ -55,6 +77,20 @@ namespace Reflex
 			template< typename Func >
 			void ForEachObject( Func function );
 
+			// Archetype storage only, calls f( count, Ts*... ) for each chunk of objects that have all the types
+			// Adding or removing components inside f is not allowed as it moves components between chunks
+			template< typename... Ts, typename Func >
+			void ForEachChunk( const Func& f ) const;
+
+			StorageMode GetStorageMode() const;
+
+			// Systems running in parallel (update stages and ParallelForEach) hold a lock while they run
+			// Objects and components can't be created or destroyed while locked, such changes must be deferred until the lock is released
+			// Taking the first lock resolves every dirty world transform, so reading them while locked never writes the cached values
+			void LockStructuralChanges();
+			void UnlockStructuralChanges();
+			bool StructuralChangesLocked() const;
+
 			template< class T >
 			void SyncHandles( EntityAllocator& m_array );
 
@@ -65,6 +101,7 @@ namespace Reflex
 			sf::RenderTarget& GetWindow();
 			Context& GetContext();
 			TileMap& GetTileMap();
+			TransformHierarchy& GetTransformHierarchy();
 			const sf::FloatRect GetBounds() const;
 			ObjectHandle GetSceneObject( const unsigned index = 0U ) const;
 
@@ -76,7 +113,8 @@ namespace Reflex
 			template< class T, typename... Args >
 			Handle< T > CreateComponent( const ObjectHandle& owner, Args&&... args );
 
-			void DestroyComponent( Type componentType, BaseHandle component );
+			void DestroyComponent( TypeId componentType, BaseHandle component );
+			void DestroyComponent( Object& owner, TypeId componentType, BaseHandle component );
 
 			template< class T >
 			void DestroyComponent( Handle< T > component );
@@ -85,49 +123,94 @@ namespace Reflex
 			template< typename... Args >
 			typename std::enable_if< sizeof...( Args ) == 0 >::type CopyComponentsFrom( const ObjectHandle& to, const ObjectHandle& from ) { }
 
-			std::unordered_map< Type, std::unique_ptr< EntityAllocator > >::iterator GetComponentAllocator( const Type& componentType, const size_t componentSize );
-			void AddComponentToSystems( const ObjectHandle& owner, const BaseHandle& componentHandle, const Type& componentType );
+			// Returns the typed pool for this component type, creating it if required
+			template< class T >
+			EntityAllocator& GetComponentAllocator();
+
+			void AddComponentToSystems( const ObjectHandle& owner, const BaseHandle& componentHandle, const TypeId componentType );
+			// Same as above for a run of components of one type, each system is checked against the whole run in turn
+			void AddComponentsToSystems( const std::vector< std::pair< ObjectHandle, BaseHandle > >& added, const TypeId componentType );
+			void AddComponentToSystem( System& system, const ObjectHandle& owner, const BaseHandle& componentHandle, const TypeId componentType );
+			void RemoveComponentFromSystems( Object& owner, const BaseHandle& componentHandle );
+			void RebuildSystemsByComponentType();
+			void RebuildUpdateStages();
+
+			// Adds a run of same type components from a command buffer, allocator growth and handle syncing happen once for the whole run
+			template< class T >
+			void PlaybackAddComponents( CommandBuffer::AddCommand* begin, CommandBuffer::AddCommand* end, const std::vector< ObjectHandle >& created );
 
 		private:
 			World() = delete;
 
 			void DeletePendingItems();
+			void ResolveWorldTransforms();
+			void DestroyPooledComponent( const TypeId componentType, const BaseHandle& component );
 			void ResetAllocator( EntityAllocator& allocator );
 
 		protected:
 			enum Variables
 			{
 				MaxLayers = 5,
+				// Playback rounds before giving up, each round only plays what the previous one recorded
+				MaxPlaybackRounds = 16,
 			};
 
 			Context m_context;
 			sf::View m_worldView;
 			sf::FloatRect m_worldBounds;
 
-			// Storage for all objects in the game
-			EntityAllocator m_objects;
+			// Storage for all objects in the game (paged, so objects never move when the allocator grows)
+			ComponentPool< Object > m_objects;
+
+			// List of components, indexed by their component type id (EG. Sprite), holds the memory of all components (paged like the objects)
+			std::vector< std::unique_ptr< EntityAllocator > > m_components;
 
-			// List of components, indexed by their type (EG. Sprite), holds the memory of all components
-			std::unordered_map< Type, std::unique_ptr< EntityAllocator > > m_components;
+			// Component memory when using archetype storage (m_components is unused in that mode)
+			StorageMode m_storageMode;
+			std::atomic< unsigned > m_structuralLocks{ 0U };
+			ArchetypeStorage m_archetypes;
 
-			// List of systems, indexed by their type, holds memory for all the Systems
-			std::unordered_map< Type, std::unique_ptr< System > > m_systems;
+			// List of systems, indexed by their system type id (null if not added), holds memory for all the Systems
+			std::vector< std::unique_ptr< System > > m_systems;
+
+			// For each component type id, the systems which require that type
+			std::vector< std::vector< System* > > m_systemsByComponentType;
+
+			// Systems grouped into stages that run one after another, the systems within a stage don't conflict and are updated in parallel
+			// Conflicting systems keep the order of m_systems (system type id order)
+			std::vector< std::vector< System* > > m_updateStages;
 
 			// Tilemap which stores object handles in the world in an efficient spacial hash map
 			TileMap m_tileMap;
 			TransformHandle m_sceneGraphRoot;
+			TransformHierarchy m_transformHierarchy;
 
 			// Removes objects / components on frame move instead of during sometime dangerous
 			std::vector< ObjectHandle > m_markedForDeletion;
+
+			// Scratch for DeletePendingItems
+			std::vector< ObjectHandle > m_deletionStack;
+			std::vector< std::pair< TypeId, BaseHandle > > m_deletionComponents;
+
+			// One command buffer per thread pool thread (indexed by ThreadPool::GetThreadIndex)
+			std::vector< std::unique_ptr< CommandBuffer > > m_commandBuffers;
+
+			// Scratch for PlaybackCommands, each buffer is swapped in here before being played back
+			CommandBuffer m_playbackCommands;
+			std::vector< ObjectHandle > m_playbackCreated;
+			std::vector< std::pair< ObjectHandle, BaseHandle > > m_playbackAdded;
+
+			// Scratch for AddComponentToSystem
+			std::vector< BaseHandle > m_systemEntryHandles;
 		};
 
 		// Template functions
 		template< class T, typename... Args >
 		T* World::AddSystem( Args&&... args )
 		{
-			const auto type = Type( typeid( T ) );
+			const auto type = GetSystemTypeId< T >();
 
-			if( m_systems.find( type ) != m_systems.end() )
+			if( type < m_systems.size() && m_systems[type] )
 			{
 				LOG_CRIT( "Trying to add a system that has already been added!" );
 				return nullptr;
@@ -135,19 +218,22 @@ namespace Reflex
 
 			auto system = std::make_unique< T >( *this, std::forward< Args >( args )... );
 
-			std::vector< Type > requiredComponentTypes;
-
 			// Register components
 			system->RegisterComponents();
 
+			const auto& requiredSignature = system->m_requiredSignature;
+
 			// Look for any existing objects that match what this system requires and add them to the system's list
 			for( auto object = m_objects.begin< Object >(); object != m_objects.end< Object >(); ++object )
 			{
+				if( ( object->m_signature & requiredSignature ) != requiredSignature )
+					continue;
+
 				std::vector< BaseHandle > tempList;
 
 				for( auto& requiredType : system->m_requiredComponentTypes )
 				{
-					const auto handle = object->GetComponent( requiredType );
+					const auto handle = object->GetComponentByType( requiredType );
 
 					if( !handle )
 						break;
@@ -158,75 +244,109 @@ namespace Reflex
 				if( tempList.size() < system->m_requiredComponentTypes.size() )
 					continue;
 
-				const auto insertionIter = system->GetInsertionIndex( tempList );
-				system->m_components.insert( insertionIter, std::move( tempList ) );
+				object->m_systemEntries.emplace_back( system.get(), system->AddEntry( tempList ) );
 			}
 
-			auto result = m_systems.insert( std::make_pair( type, std::move( system ) ) );
-			assert( result.second );
+			if( type >= m_systems.size() )
+				m_systems.resize( type + 1 );
 
-			result.first->second->OnSystemStartup();
+			m_systems[type] = std::move( system );
+			RebuildSystemsByComponentType();
+			RebuildUpdateStages();
+			m_systems[type]->OnSystemStartup();
 
-			return ( T* )result.first->second.get();
+			return ( T* )m_systems[type].get();
 		}
 
 		template< class T >
 		void World::RemoveSystem()
 		{
-			const auto systemType = Type( typeid( T ) );
+			const auto systemType = GetSystemTypeId< T >();
 
-			for( auto iter = m_systems.begin(); iter != m_systems.end(); ++iter )
+			if( systemType < m_systems.size() && m_systems[systemType] )
 			{
-				if( systemType == iter->first )
+				auto* system = m_systems[systemType].get();
+
+				// Forget any entries objects have in this system
+				for( auto object = m_objects.begin< Object >(); object != m_objects.end< Object >(); ++object )
 				{
-					iter->second->OnSystemShutdown();
-					iter->second.reset();
-					m_systems.erase( iter );
-					break;
+					auto& entries = object->m_systemEntries;
+					entries.erase( std::remove_if( entries.begin(), entries.end(), [system]( const std::pair< System*, unsigned >& entry )
+					{
+						return entry.first == system;
+					} ), entries.end() );
 				}
+
+				m_systems[systemType]->OnSystemShutdown();
+				m_systems[systemType].reset();
+				RebuildSystemsByComponentType();
+				RebuildUpdateStages();
 			}
 		}
 
 		template< class T >
 		T* World::GetSystem()
 		{
-			const auto systemType = Type( typeid( T ) );
-
-			for( auto iter = m_systems.begin(); iter != m_systems.end(); ++iter )
-				if( systemType == iter->first )
-					return ( T* )iter->second.get();
-
-			return nullptr;
+			const auto systemType = GetSystemTypeId< T >();
+			return systemType < m_systems.size() ? ( T* )m_systems[systemType].get() : nullptr;
 		}
 
 		template< class T >
 		void World::ForwardRegisterComponent()
 		{
-			const auto componentType = Type( typeid( T ) );
+			if( m_storageMode == StorageMode::Archetype )
+				m_archetypes.RegisterType< T >();
+			else
+				GetComponentAllocator< T >();
+		}
+
+		template< class T >
+		EntityAllocator& World::GetComponentAllocator()
+		{
+			const auto componentType = GetComponentTypeId< T >();
+
+			// Create a typed pool for this type if one doesn't already exist
+			if( componentType >= m_components.size() )
+				m_components.resize( componentType + 1 );
 
-			if( m_components.find( componentType ) == m_components.end() )
-				m_components.insert( std::make_pair( componentType, std::make_unique< EntityAllocator >( sizeof( T ), 1000 ) ) );
+			if( !m_components[componentType] )
+				m_components[componentType] = std::make_unique< ComponentPool< T > >( 1000, EntityAllocator::GrowthMode::Paged );
+
+			return *m_components[componentType];
 		}
 
 		template< class T, typename... Args >
 		Handle< T > World::CreateComponent( const ObjectHandle& owner, Args&&... args )
 		{
-			const auto componentType = Type( typeid( T ) );
-			const auto found = GetComponentAllocator( componentType, sizeof( T ) );
-			
-			// This should never happen
-			assert( found != m_components.end() );
+			assert( !StructuralChangesLocked() );
 
-			// Allocate the component's memory from the allocator
-			auto* component = ( T* )found->second->Allocate();
+			const auto componentType = GetComponentTypeId< T >();
+			T* component = nullptr;
+
+			// Allocate the component's memory from the allocator (or a row in the object's new archetype)
+			if( m_storageMode == StorageMode::Archetype )
+			{
+				m_archetypes.RegisterType< T >();
+				component = ( T* )m_archetypes.BeginAddComponent( *owner.Get(), componentType );
+			}
+			else
+			{
+				component = ( T* )GetComponentAllocator< T >().Allocate();
+			}
 
 			// Create handle & construct
 			const auto componentHandle = GetHandleManager().Insert< T >( component );
 			new ( component ) T( std::forward< Args >( args )... );
 			component->m_self = componentHandle;
+			component->m_typeId = componentType;
 			component->SetOwningObject( owner );
+			owner->m_signature.set( componentType );
 
-			SyncHandles< T >( *found->second.get() );
+			// Now the new component is constructed it is safe to move the owner's other components over
+			if( m_storageMode == StorageMode::Archetype )
+				m_archetypes.EndAddComponent( *owner.Get() );
+			else
+				SyncHandles< T >( GetComponentAllocator< T >() );
 
 			// Here we want to check if we should add this component to any systems
 			AddComponentToSystems( owner, componentHandle, componentType );
@@ -238,7 +358,7 @@ namespace Reflex
 		Handle< T > Object::AddComponent(Args&&... args)
 		{
 			auto component = m_world.CreateComponent< T >(ObjectHandle(m_self), std::forward< Args >(args)...);
-			m_components.emplace_back(Type(typeid(T)), component);
+			m_components.emplace_back(GetComponentTypeId< T >(), component);
 			component->OnConstructionComplete();
 			return component;
 		}
@@ -246,8 +366,7 @@ namespace Reflex
 		template< class T >
 		void World::DestroyComponent( Handle< T > component )
 		{
-			const auto componentType = Type( typeid( *component.Get() ) );
-			DestroyComponent( componentType, component );
+			DestroyComponent( component->GetTypeId(), component );
 		}
 
 		template< typename T, typename... Args >
@@ -263,10 +382,13 @@ namespace Reflex
 
 				// Pre allocate any memory required to fit the new component (we must do this now because we are passing in a reference to a 
 				// component to copy from and if the allocator expands, the reference would be invalid).
-				const auto componentType = Type( typeid( T ) );
-				const auto found = GetComponentAllocator( componentType, sizeof( T ) );
-				if( found->second->PreAllocate() )
-					SyncHandles< T >( *found->second );
+				// Archetype storage doesn't need this as nothing moves until the new component has been constructed
+				if( m_storageMode == StorageMode::Pooled )
+				{
+					auto& allocator = GetComponentAllocator< T >();
+					if( allocator.PreAllocate() )
+						SyncHandles< T >( allocator );
+				}
 
 				// Add the component (we know now it is safe to get a reference to the other component and pass it through)
 				to->AddComponent< T >( *component.Get() );
@@ -289,9 +411,74 @@ namespace Reflex
 				function( ( Object* )m_objects[i] );
 		}
 
+		template< typename... Ts, typename Func >
+		void World::ForEachChunk( const Func& f ) const
+		{
+			assert( m_storageMode == StorageMode::Archetype );
+			m_archetypes.ForEachChunk< Ts... >( f );
+		}
+
+		template< class T >
+		void World::PlaybackAddComponents( CommandBuffer::AddCommand* begin, CommandBuffer::AddCommand* end, const std::vector< ObjectHandle >& created )
+		{
+			const auto componentType = GetComponentTypeId< T >();
+			m_playbackAdded.clear();
+
+			if( m_storageMode == StorageMode::Archetype )
+				m_archetypes.RegisterType< T >();
+			else
+				GetComponentAllocator< T >().Reserve( ( unsigned )( end - begin ) );
+
+			for( auto* command = begin; command != end; ++command )
+			{
+				const auto owner = CommandBuffer::Resolve( command->object, created );
+
+				if( !owner.IsValid() || owner->IsDestroyed() )
+					continue;
+
+				T* component = nullptr;
+
+				if( m_storageMode == StorageMode::Archetype )
+					component = ( T* )m_archetypes.BeginAddComponent( *owner.Get(), componentType );
+				else
+					component = ( T* )GetComponentAllocator< T >().Allocate();
+
+				const auto componentHandle = GetHandleManager().Insert< T >( component );
+				command->construct( component );
+				component->m_self = componentHandle;
+				component->m_typeId = componentType;
+				component->SetOwningObject( owner );
+				owner->m_signature.set( componentType );
+
+				if( m_storageMode == StorageMode::Archetype )
+					m_archetypes.EndAddComponent( *owner.Get() );
+
+				m_playbackAdded.emplace_back( owner, componentHandle );
+			}
+
+			if( m_storageMode == StorageMode::Pooled )
+				SyncHandles< T >( GetComponentAllocator< T >() );
+
+			// Only now that every handle is correct can the components be matched against systems
+			AddComponentsToSystems( m_playbackAdded, componentType );
+
+			for( auto& added : m_playbackAdded )
+			{
+				added.first->m_components.emplace_back( componentType, added.second );
+				Handle< T >( added.second )->OnConstructionComplete();
+			}
+		}
+
+		template< class T >
+		void CommandBuffer::PlaybackAddComponents( World& world, AddCommand* begin, AddCommand* end, const std::vector< ObjectHandle >& created )
+		{
+			world.PlaybackAddComponents< T >( begin, end, created );
+		}
+
 		template< class T >
 		void World::SyncHandles( EntityAllocator& m_array )
 		{
+			// Paged allocators never set the grew flag, so this is a no-op for them
 			if( m_array.Grew() )
 			{
 				for( auto i = m_array.begin< T >(); i != m_array.end< T >(); ++i )
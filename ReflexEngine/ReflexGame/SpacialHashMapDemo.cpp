@@ -10,6 +10,9 @@ SpacialHashMapDemo::SpacialHashMapDemo( Reflex::Core::StateManager& stateManager
 	, m_world( context, m_bounds, 250U )
 	, m_objectCount( 500 )
 {
+	// Every object moves every frame, so rebuilding the grid beats updating it
+	m_world.GetTileMap().SetStorageMode( Reflex::Core::TileMap::StorageMode::Contiguous );
+
 	for( unsigned i = 0U; i < m_objectCount; ++i )
 	{
 		auto newObject = m_world.CreateObject( sf::Vector2f( m_bounds.left + Reflex::RandomFloat() * m_bounds.width, m_bounds.top + Reflex::RandomFloat() * m_bounds.height ) );
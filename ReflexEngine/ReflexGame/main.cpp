@@ -5,6 +5,7 @@
 #include "MenuState.h"
 #include "SpacialHashMapDemo.h"
 #include "..\ReflexEngine\SFMLObjectComponent.h"
+#include "..\ReflexEngine\ComponentPool.h"
 
 enum StateTypes : unsigned
 {
@@ -22,6 +23,9 @@ public:
 	sf::Vector2f velocity;
 };
 
+// Just a handle and a vector, so the pool can relocate it with memcpy
+REFLEX_TRIVIALLY_RELOCATABLE( Velocity )
+
 class VelocitySystem : public Reflex::Systems::System
 {
 public:
@@ -31,13 +35,16 @@ public:
 	{
 		RequiresComponent( Reflex::Components::Transform );
 		RequiresComponent( Velocity );
+		WritesComponent( Reflex::Components::Transform );
+		ReadsComponent( Velocity );
 	}
 
 	virtual void Update( const float deltaTime ) 
 	{ 
-		ForEachSystemComponent< Reflex::Components::Transform, Velocity >( []( const auto& t, const auto& v )
+		// Moving only touches this object's own transform, see ParallelForEach
+		ParallelForEach< Reflex::Systems::Write< Reflex::Components::Transform >, Reflex::Systems::Read< Velocity > >( []( const auto& context, auto& t, const auto& v )
 			{
-				t->move( v->velocity );
+				t.move( v.velocity );
 			} );
 	}
 
@@ -52,7 +59,7 @@ public:
 		, m_bounds( 0.0f, 0.0f, (float )context.window->getSize().x, (float )context.window->getSize().y )
 		, m_world( context, m_bounds, 300U )
 	{
-		//m_world.AddSystem< VelocitySystem >();
+		m_world.AddSystem< VelocitySystem >();
 
 		for( unsigned i = 0; i < 1000; ++i )
 		{